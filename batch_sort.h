@@ -0,0 +1,92 @@
+/*
+ * File: batch_sort.h
+ *
+ * Description:
+ * Sorts a batch of many independent arrays, given either as a list of spans
+ * or in CSR form (values plus count + 1 offsets, array i being
+ * values[offsets[i], offsets[i + 1])), inside a single OpenMP parallel region
+ * instead of one region per array:
+ * - Arrays of at least BATCH_SPLIT_MIN_SIZE keys that are also larger than an
+ *   even share of the batch are split across threads as quicksort tasks.
+ * - All other arrays are handed out whole, largest first, through a dynamic
+ *   worksharing loop, so each is sorted by one thread.
+ * Threads that run out of small arrays pick up the large arrays' tasks at the
+ * end of the region, which balances the whole batch. Arrays and task leaves
+ * are sorted with leafSort, blockQuickSort by default.
+ */
+
+#ifndef BATCH_SORT_H
+#define BATCH_SORT_H
+
+#include <vector>
+#include <algorithm>
+#include <span>
+#include "omp_compat.h"
+#include "partition.h"
+#include "block_quicksort.h"
+#include "simd_kernels.h"
+
+// Sequential sort of arr[left, right] used for whole arrays and task leaves
+using RangeSort = void (*)(int* arr, int left, int right);
+
+const long long BATCH_SPLIT_MIN_SIZE = 1 << 16;
+const int BATCH_TASK_GRAIN = 1 << 14;
+
+// Quicksort of arr[left, right] that spawns the right side of every
+// partition as a task; the enclosing region's closing barrier joins them
+inline void batchQuickSortTask(int* arr, int left, int right, RangeSort leafSort) {
+    while (right - left + 1 > BATCH_TASK_GRAIN) {
+        PartitionBounds bounds = simdPartitionRange(arr, left, right);
+        int rightBegin = bounds.gt + 1;
+        #pragma omp task firstprivate(arr, rightBegin, right, leafSort)
+        batchQuickSortTask(arr, rightBegin, right, leafSort);
+        right = bounds.lt - 1;
+    }
+    leafSort(arr, left, right);
+}
+
+inline void sortBatch(std::span<const std::span<int>> arrays, RangeSort leafSort = blockQuickSort) {
+    long long total = 0;
+    for (std::span<int> array : arrays) total += static_cast<long long>(array.size());
+    const long long evenShare = total / ompMaxThreads();
+
+    std::vector<size_t> splitArrays, wholeArrays;
+    for (size_t i = 0; i < arrays.size(); i++) {
+        long long n = static_cast<long long>(arrays[i].size());
+        if (n >= BATCH_SPLIT_MIN_SIZE && n > evenShare) splitArrays.push_back(i);
+        else if (n > 1) wholeArrays.push_back(i);
+    }
+    std::sort(wholeArrays.begin(), wholeArrays.end(), [&](size_t a, size_t b) {
+        return arrays[a].size() > arrays[b].size();
+    });
+    const long long wholeCount = static_cast<long long>(wholeArrays.size());
+
+    #pragma omp parallel
+    {
+        #pragma omp single nowait
+        {
+            for (size_t i : splitArrays) {
+                int* arr = arrays[i].data();
+                int right = static_cast<int>(arrays[i].size()) - 1;
+                #pragma omp task firstprivate(arr, right, leafSort)
+                batchQuickSortTask(arr, 0, right, leafSort);
+            }
+        }
+
+        #pragma omp for schedule(dynamic, 1) nowait
+        for (long long k = 0; k < wholeCount; k++) {
+            std::span<int> array = arrays[wholeArrays[k]];
+            leafSort(array.data(), 0, static_cast<int>(array.size()) - 1);
+        }
+    }
+}
+
+inline void sortBatch(int* values, const long long* offsets, size_t count, RangeSort leafSort = blockQuickSort) {
+    std::vector<std::span<int>> arrays(count);
+    for (size_t i = 0; i < count; i++) {
+        arrays[i] = std::span<int>(values + offsets[i], values + offsets[i + 1]);
+    }
+    sortBatch(arrays, leafSort);
+}
+
+#endif // BATCH_SORT_H
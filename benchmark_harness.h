@@ -0,0 +1,193 @@
+/*
+ * File: benchmark_harness.h
+ *
+ * Description:
+ * Measurement helpers for complete_performance_analysis. Every engine is
+ * timed on the same input, after a few untimed warmup runs, and the
+ * engines take turns within every repetition so that drift on the machine
+ * affects all of them alike. A series of samples is summarized by its
+ * median with an approximate 95% distribution-free confidence interval
+ * (order statistics of the binomial(n, 1/2) ranks), its minimum and its 99th
+ * percentile.
+ *
+ * The inputs live in a BenchmarkArena: a pristine master copy and the working
+ * buffer, allocated once at the largest input size on huge pages where the
+ * system offers them. Before every run the working buffer is refreshed from
+ * the master with a parallel memcpy, so the loop itself never allocates,
+ * never page-faults and never shares a timed run with the allocator. Every
+ * result is verified in place against the master's checksum (see
+ * sort_verify.h), so no sorted reference copy is needed.
+ *
+ * Results are also written as JSON, one object per (engine, input
+ * distribution, size) with the summary and the raw samples:
+ *
+ *   {"schema": "seq2par2-benchmark/2", "repetitions": R, "warmups": W,
+ *    "threads": T, "results": [{"engine": "Radix", "distribution": "uniform",
+ *    "size": 10000, "median": ..., "ci_low": ..., "ci_high": ..., "min": ..., "p99": ...,
+ *    "mean": ..., "speedup": ..., "efficiency": ..., "samples": [...]}, ...]}
+ *
+ * With counters enabled, each result also carries the counters of its median
+ * run: "counters": {"cycles", "instructions", "llc_misses", "branch_misses"
+ * and "unscheduled_groups" (when the PMU is available; counts are scaled for
+ * multiplexing, see perf_counters.h), "busy", "idle", "thread_busy": [...]}.
+ */
+
+#ifndef BENCHMARK_HARNESS_H
+#define BENCHMARK_HARNESS_H
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <cstdlib>
+#include <span>
+#include "perf_counters.h"
+#include "numa_buffer.h"
+#include "sort_verify.h"
+
+const int BENCHMARK_DEFAULT_REPETITIONS = 11;
+const int BENCHMARK_DEFAULT_WARMUPS = 2;
+
+struct SampleSummary {
+    double median = 0;
+    double ciLow = 0;   // bounds of the ~95% confidence interval of the median
+    double ciHigh = 0;
+    double min = 0;
+    double p99 = 0;
+    double mean = 0;
+};
+
+inline SampleSummary summarizeSamples(std::vector<double> samples) {
+    SampleSummary summary;
+    const int n = static_cast<int>(samples.size());
+    if (n == 0) return summary;
+    std::sort(samples.begin(), samples.end());
+
+    summary.median = n % 2 == 1 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+    double halfWidth = 0.98 * std::sqrt(static_cast<double>(n));
+    int low = std::max(0, static_cast<int>(std::floor(n / 2.0 - halfWidth)));
+    int high = std::min(n - 1, static_cast<int>(std::ceil(n / 2.0 + halfWidth)));
+    summary.ciLow = samples[low];
+    summary.ciHigh = samples[high];
+    summary.min = samples.front();
+    summary.p99 = samples[std::max(0, static_cast<int>(std::ceil(0.99 * n)) - 1)];
+    summary.mean = std::accumulate(samples.begin(), samples.end(), 0.0) / n;
+    return summary;
+}
+
+// Parses a comma-separated list of positive integers such as "10000,100000"
+inline std::vector<int> parseIntList(const char* text) {
+    std::vector<int> values;
+    const char* p = text;
+    while (*p != '\0') {
+        char* end;
+        long value = std::strtol(p, &end, 10);
+        if (end == p) break;
+        if (value > 0) values.push_back(static_cast<int>(value));
+        p = *end == ',' ? end + 1 : end;
+    }
+    return values;
+}
+
+// Input buffers of a benchmark, reused for every size and distribution
+class BenchmarkArena {
+public:
+    BenchmarkArena(size_t capacity, NumaPlacement placement)
+        : master_(capacity, placement, true), work_(capacity, placement, true) {}
+
+    size_t capacity() const { return master_.size(); }
+
+    // Where the next input is written; call prepare(n) once it is complete
+    int* master() { return master_.data(); }
+
+    // Takes the checksum of master[0, n) for matches()
+    void prepare(size_t n) {
+        checksum_ = binaryChecksum(master_.data(), static_cast<long long>(n));
+    }
+
+    // Restores the working buffer to master[0, n) and returns it
+    std::span<int> refresh(size_t n) {
+        parallelCopy(work_.data(), master_.data(), n);
+        return {work_.data(), n};
+    }
+
+    // True when the working buffer holds the sorted input
+    bool matches(size_t n) const {
+        SortVerifier verifier = verifySorted(work_.data(), static_cast<long long>(n));
+        return verifier.sorted() && verifier.checksum() == checksum_;
+    }
+
+    const char* pageSizeName() const {
+        switch (work_.hugePages()) {
+            case NumaBuffer<int>::HugePages::Explicit: return "2 MiB (MAP_HUGETLB)";
+            case NumaBuffer<int>::HugePages::Transparent: return "transparent huge pages";
+            default: return "base pages";
+        }
+    }
+
+private:
+    NumaBuffer<int> master_;
+    NumaBuffer<int> work_;
+    uint64_t checksum_ = 0;
+};
+
+// Samples and summary of one engine on one input
+struct BenchmarkResult {
+    std::string engine;
+    std::string distribution;  // see input_distributions.h
+    int size = 0;
+    std::vector<double> samples;
+    SampleSummary summary;
+    double speedup = 1.0;  // sequential median / this median on the same input
+    bool hasCounters = false;
+    CounterSample counters;  // of the median run, see perf_counters.h
+};
+
+inline void writeBenchmarkJson(const std::string& path, const std::vector<BenchmarkResult>& results,
+                               int repetitions, int warmups, int threads) {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Error opening file: " << path << std::endl;
+        exit(1);
+    }
+
+    file.precision(9);
+    file << "{\"schema\": \"seq2par2-benchmark/2\", \"repetitions\": " << repetitions
+         << ", \"warmups\": " << warmups << ", \"threads\": " << threads << ", \"results\": [";
+    for (size_t r = 0; r < results.size(); r++) {
+        const BenchmarkResult& result = results[r];
+        const SampleSummary& s = result.summary;
+        file << (r == 0 ? "\n" : ",\n")
+             << "  {\"engine\": \"" << result.engine << "\", \"distribution\": \"" << result.distribution
+             << "\", \"size\": " << result.size
+             << ", \"median\": " << s.median << ", \"ci_low\": " << s.ciLow << ", \"ci_high\": " << s.ciHigh
+             << ", \"min\": " << s.min << ", \"p99\": " << s.p99 << ", \"mean\": " << s.mean
+             << ", \"speedup\": " << result.speedup << ", \"efficiency\": " << result.speedup / threads
+             << ", \"samples\": [";
+        for (size_t i = 0; i < result.samples.size(); i++) {
+            file << (i == 0 ? "" : ", ") << result.samples[i];
+        }
+        file << "]";
+        if (result.hasCounters) {
+            const CounterSample& c = result.counters;
+            file << ", \"counters\": {";
+            if (c.hardware) {
+                file << "\"cycles\": " << c.cycles << ", \"instructions\": " << c.instructions
+                     << ", \"llc_misses\": " << c.llcMisses << ", \"branch_misses\": " << c.branchMisses
+                     << ", \"unscheduled_groups\": " << c.unscheduledGroups << ", ";
+            }
+            file << "\"busy\": " << c.busy << ", \"idle\": " << c.idle << ", \"thread_busy\": [";
+            for (size_t i = 0; i < c.threadBusy.size(); i++) {
+                file << (i == 0 ? "" : ", ") << c.threadBusy[i];
+            }
+            file << "]}";
+        }
+        file << "}";
+    }
+    file << "\n]}" << std::endl;
+}
+
+#endif // BENCHMARK_HARNESS_H
@@ -0,0 +1,194 @@
+/*
+ * File: binary_io.h
+ *
+ * Description:
+ * Binary on-disk format for integer datasets, used as an alternative to the
+ * CSV files. A file is a 32-byte header followed by raw little-endian 32-bit
+ * integers:
+ *
+ *   offset  size  field
+ *        0     8  magic "S2PBIN1\0"
+ *        8     8  element count
+ *       16     4  element width in bytes (always 4)
+ *       20     4  flags (bit 0: payload is sorted ascending)
+ *       24     8  checksum of the payload
+ *
+ * The checksum is an order-independent multiset hash (a sum of mixed values),
+ * so it can be computed in parallel and a sorted output file carries the same
+ * checksum as the input it came from.
+ *
+ * Files are written and read through mmap. A mapped file can be sorted in
+ * place: privately (copy-on-write, the file is untouched) or shared (the sort
+ * is written back to the file).
+ */
+
+#ifndef BINARY_IO_H
+#define BINARY_IO_H
+
+#include <iostream>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "random_engine.h"
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "binary_io.h stores payloads in host order and expects a little-endian host");
+
+const char BINARY_MAGIC[8] = {'S', '2', 'P', 'B', 'I', 'N', '1', '\0'};
+const uint32_t BINARY_FLAG_SORTED = 1u;
+
+struct BinaryHeader {
+    char magic[8];
+    uint64_t count;
+    uint32_t elementWidth;
+    uint32_t flags;
+    uint64_t checksum;
+};
+
+static_assert(sizeof(BinaryHeader) == 32, "BinaryHeader must match the on-disk layout");
+
+// Order-independent checksum of numbers[0, N), a sum of mixValue (see
+// random_engine.h)
+inline uint64_t binaryChecksum(const int* numbers, long long N) {
+    uint64_t sum = 0;
+    #pragma omp parallel for reduction(+:sum) schedule(static)
+    for (long long i = 0; i < N; i++) {
+        sum += mixValue(static_cast<uint32_t>(numbers[i]));
+    }
+    return sum;
+}
+
+inline BinaryHeader makeBinaryHeader(uint64_t count, uint64_t checksum, bool sorted) {
+    BinaryHeader header;
+    std::memcpy(header.magic, BINARY_MAGIC, sizeof(header.magic));
+    header.count = count;
+    header.elementWidth = sizeof(int);
+    header.flags = sorted ? BINARY_FLAG_SORTED : 0u;
+    header.checksum = checksum;
+    return header;
+}
+
+// True if header describes a payload of 32-bit values filling a file of fileSize bytes
+inline bool isValidBinaryHeader(const BinaryHeader& header, size_t fileSize) {
+    return std::memcmp(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC)) == 0 &&
+           header.elementWidth == sizeof(int) &&
+           sizeof(BinaryHeader) + header.count * sizeof(int) == fileSize;
+}
+
+// Writes numbers[0, N) with a header through a shared mapping of the file
+inline void writeBinaryFile(const char* filename, const int* numbers, int N, bool sorted) {
+    int fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        exit(1);
+    }
+
+    size_t payloadBytes = static_cast<size_t>(N > 0 ? N : 0) * sizeof(int);
+    size_t size = sizeof(BinaryHeader) + payloadBytes;
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        std::cerr << "Error writing file: " << filename << std::endl;
+        exit(1);
+    }
+
+    void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Error mapping file: " << filename << std::endl;
+        exit(1);
+    }
+
+    uint64_t count = static_cast<uint64_t>(N > 0 ? N : 0);
+    BinaryHeader header = makeBinaryHeader(count, binaryChecksum(numbers, count), sorted);
+    std::memcpy(mapping, &header, sizeof(header));
+
+    int* payload = reinterpret_cast<int*>(static_cast<char*>(mapping) + sizeof(BinaryHeader));
+    #pragma omp parallel for schedule(static)
+    for (long long i = 0; i < static_cast<long long>(header.count); i++) {
+        payload[i] = numbers[i];
+    }
+
+    munmap(mapping, size);
+}
+
+// Memory-mapped view of a binary dataset. The payload is writable either way:
+// with inPlace = false writes stay private to the process, with inPlace = true
+// they go back to the file.
+class MappedBinaryFile {
+public:
+    MappedBinaryFile(const char* filename, bool inPlace = false) {
+        int fd = open(filename, inPlace ? O_RDWR : O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "Error opening file: " << filename << std::endl;
+            exit(1);
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(BinaryHeader)) {
+            std::cerr << "Error: not a binary dataset: " << filename << std::endl;
+            exit(1);
+        }
+        size_ = static_cast<size_t>(st.st_size);
+
+        mapping_ = mmap(nullptr, size_, PROT_READ | PROT_WRITE, inPlace ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapping_ == MAP_FAILED) {
+            std::cerr << "Error mapping file: " << filename << std::endl;
+            exit(1);
+        }
+
+        std::memcpy(&header_, mapping_, sizeof(header_));
+        if (!isValidBinaryHeader(header_, size_)) {
+            std::cerr << "Error: corrupt binary dataset: " << filename << std::endl;
+            exit(1);
+        }
+    }
+
+    ~MappedBinaryFile() {
+        munmap(mapping_, size_);
+    }
+
+    MappedBinaryFile(const MappedBinaryFile&) = delete;
+    MappedBinaryFile& operator=(const MappedBinaryFile&) = delete;
+
+    int* data() {
+        return reinterpret_cast<int*>(static_cast<char*>(mapping_) + sizeof(BinaryHeader));
+    }
+
+    int size() const {
+        return static_cast<int>(header_.count);
+    }
+
+    bool isSorted() const {
+        return (header_.flags & BINARY_FLAG_SORTED) != 0;
+    }
+
+    uint64_t checksum() const {
+        return header_.checksum;
+    }
+
+    // Recomputes the payload checksum and compares it with the header
+    bool verifyChecksum() {
+        return binaryChecksum(data(), size()) == header_.checksum;
+    }
+
+private:
+    void* mapping_;
+    size_t size_;
+    BinaryHeader header_;
+};
+
+// Returns true if filename exists and starts with a binary dataset header
+inline bool isBinaryFile(const char* filename) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return false;
+    char magic[sizeof(BINARY_MAGIC)];
+    bool match = read(fd, magic, sizeof(magic)) == static_cast<ssize_t>(sizeof(magic)) &&
+                 std::memcmp(magic, BINARY_MAGIC, sizeof(magic)) == 0;
+    close(fd);
+    return match;
+}
+
+#endif // BINARY_IO_H
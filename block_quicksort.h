@@ -0,0 +1,101 @@
+/*
+ * File: block_quicksort.h
+ *
+ * Description:
+ * Portable branchless quicksort engine for machines without the SIMD kernels.
+ * Partitioning follows the block variant of Lomuto's scheme (Aumüller and
+ * Hass, "Simple and Fast BlockQuicksort using Lomuto's Partitioning Scheme"):
+ * each block of BLOCK_PARTITION_SIZE keys is first scanned without branches,
+ * recording the offsets of keys below the pivot, and those keys are then
+ * swapped into place in one batch. This removes the unpredictable branch of
+ * the classic loop.
+ *
+ * The engine is an introsort: tiny ranges use insertion sort, and once the
+ * recursion gets deeper than 2 * log2(n) the range falls back to heapsort, so
+ * the worst case stays O(n log n). When a partition comes out badly skewed,
+ * keys equal to the pivot are gathered next to it and skipped, which keeps
+ * duplicate-heavy inputs fast.
+ */
+
+#ifndef BLOCK_QUICKSORT_H
+#define BLOCK_QUICKSORT_H
+
+#include <algorithm>
+#include <cstdint>
+#include "partition.h"
+
+const int BLOCK_PARTITION_SIZE = 128;
+const int BLOCK_QUICKSORT_INSERTION_THRESHOLD = 16;
+
+// Moves the keys of arr[left, right) below pivot (at or below it if orEqual)
+// to the front with branchless block scans, and returns the index of the first
+// key that stays behind
+inline int blockLomutoPartition(int* arr, int left, int right, int pivot, bool orEqual) {
+    uint8_t offsets[BLOCK_PARTITION_SIZE];
+    int boundary = left;
+
+    for (int block = left; block < right; block += BLOCK_PARTITION_SIZE) {
+        int n = std::min(BLOCK_PARTITION_SIZE, right - block);
+        int count = 0;
+        if (orEqual) {
+            for (int k = 0; k < n; k++) {
+                offsets[count] = static_cast<uint8_t>(k);
+                count += arr[block + k] <= pivot;
+            }
+        } else {
+            for (int k = 0; k < n; k++) {
+                offsets[count] = static_cast<uint8_t>(k);
+                count += arr[block + k] < pivot;
+            }
+        }
+        for (int t = 0; t < count; t++) {
+            std::swap(arr[boundary++], arr[block + offsets[t]]);
+        }
+    }
+    return boundary;
+}
+
+// Three-way result of one block partition step of arr[left, right]
+inline PartitionBounds blockPartitionRange(int* arr, int left, int right) {
+    std::swap(arr[choosePivotIndex(arr, left, right)], arr[right]);
+    int pivot = arr[right];
+
+    int split = blockLomutoPartition(arr, left, right, pivot, false);
+    std::swap(arr[split], arr[right]);
+
+    // Skewed split: gather the pivot's duplicates so they are not re-sorted
+    int gt = split;
+    if (split - left < (right - left) / 8) {
+        gt = blockLomutoPartition(arr, split + 1, right + 1, pivot, true) - 1;
+    }
+    return {split, gt};
+}
+
+inline void blockQuickSortImpl(int* arr, int left, int right, int depthLimit) {
+    while (right - left + 1 > BLOCK_QUICKSORT_INSERTION_THRESHOLD) {
+        if (depthLimit-- == 0) {
+            std::make_heap(arr + left, arr + right + 1);
+            std::sort_heap(arr + left, arr + right + 1);
+            return;
+        }
+
+        PartitionBounds bounds = blockPartitionRange(arr, left, right);
+        if (bounds.lt - left < right - bounds.gt) {
+            blockQuickSortImpl(arr, left, bounds.lt - 1, depthLimit);
+            left = bounds.gt + 1;
+        } else {
+            blockQuickSortImpl(arr, bounds.gt + 1, right, depthLimit);
+            right = bounds.lt - 1;
+        }
+    }
+    insertionSort(arr, left, right);
+}
+
+// Sorts arr[left, right] with the branchless block introsort
+inline void blockQuickSort(int* arr, int left, int right) {
+    if (left >= right) return;
+    int depthLimit = 2 * (32 - __builtin_clz(static_cast<unsigned>(right - left + 1)));
+    blockQuickSortImpl(arr, left, right, depthLimit);
+}
+
+#endif // BLOCK_QUICKSORT_H
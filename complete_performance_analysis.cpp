@@ -1,17 +1,33 @@
 /*
  * File: complete_performance_analysis.cpp
- * Compile: g++ -fopenmp complete_performance_analysis.cpp -o complete_performance_analysis
+ * Compile: g++ -std=c++20 -fopenmp complete_performance_analysis.cpp -o complete_performance_analysis
  * Author: Samuel Chamalé
  * Date: 8-29-2024
  *
  * Description:
  * This program is designed to analyze and compare the performance of the
- * sequential, parallel, and improved parallel implementations of the quicksort algorithm.
+ * sequential, parallel, and improved parallel implementations of the quicksort algorithm,
+ * alongside a parallel radix sort for the bounded integer key range and a parallel
+ * multiway mergesort whose speed does not depend on pivot choices, and a parallel
+ * sample sort whose bucket count scales with the number of threads. The task-based
+ * quicksort also runs on a work-stealing scheduler independent of OpenMP tasks,
+ * and a reusable SortContext keeps its pinned workers and scratch memory warm
+ * across calls. A NUMA-aware mergesort sorts within each node before one
+ * final cross-node merge.
  * It performs the following tasks:
- * 1. Runs each implementation multiple times with varying input sizes.
- * 2. Measures and records execution times for each run.
+ * 1. Runs each implementation multiple times with varying input sizes and
+ *    input distributions (sorted, reverse, nearly sorted, few unique, Zipf,
+ *    sawtooth, organ pipe, all equal and uniform), after untimed warmup runs
+ *    and on pre-faulted buffers.
+ * 2. Measures and records execution times for each run, summarized by their
+ *    median with a confidence interval, minimum and 99th percentile.
  * 3. Calculates speedup and efficiency metrics.
  * 4. Generates performance reports and graphs.
+ * 5. With --scaling, repeats the measurements across thread counts and
+ *    OMP_PROC_BIND / OMP_PLACES policies, for strong and weak scaling.
+ * 6. With --distributed, runs the MPI sample sort of
+ *    distributed_sample_sort.cpp across rank and thread counts (hybrid
+ *    MPI+OpenMP), for strong and weak scaling across nodes.
  *
  * The program helps in understanding the scalability and efficiency of the
  * parallel implementations compared to the sequential version across different
@@ -27,192 +43,934 @@
 #include <ctime>
 #include <omp.h>
 #include <random>
+#include <string>
+#include <sstream>
+#include <cstring>
+#include <cmath>
+#include <span>
+#include <memory>
+#include <numeric>
+#include <thread>
+#include <climits>
+#include <cstdio>
+#include <unistd.h>
+#include "binary_io.h"
+#include "radix_sort.h"
+#include "partition.h"
+#include "merge_sort.h"
+#include "sample_sort.h"
+#include "sort_tuning.h"
+#include "simd_kernels.h"
+#include "block_quicksort.h"
+#include "work_stealing.h"
+#include "sort_context.h"
+#include "batch_sort.h"
+#include "record_sort.h"
+#include "benchmark_harness.h"
+#include "input_distributions.h"
+#include "perf_counters.h"
+#include "task_trace.h"
+#include "numa_buffer.h"
+#include "sort_verify.h"
+#include "sort_engines.h"
+
+// Size of the random array the --tune sweep calibrates on
+const int TUNING_CALIBRATION_SIZE = 2000000;
+
+// Shape of the --batch benchmark: that many arrays of log-uniform sizes
+const int BATCH_BENCHMARK_ARRAYS = 2000;
+const int BATCH_BENCHMARK_MIN_SIZE = 1000;
+const int BATCH_BENCHMARK_MAX_SIZE = 100000;
+
+// Keys per thread of the --scaling sweep's weak scaling runs
+const int SCALING_DEFAULT_WEAK_SIZE = 1000000;
+
+// Launcher and program of the --distributed sweep; -x forwards the thread
+// count to remote ranks under Open MPI (MPICH: "mpiexec -genvall")
+const char* DISTRIBUTED_DEFAULT_MPIRUN = "mpirun -x OMP_NUM_THREADS";
+const char* DISTRIBUTED_DEFAULT_PROGRAM = "./distributed_sample_sort";
+
+// Input seed of --binary runs without --seed, so that they keep finding the
+// cached inputs of earlier runs
+const uint64_t BINARY_INPUT_DEFAULT_SEED = 1;
+
+// Record count of the --records benchmark
+const int RECORD_BENCHMARK_SIZE = 1000000;
+
+// 64-byte record: an int key and a payload derived from it, so that a record
+// torn apart by a sort shows up in the check
+struct BenchmarkRecord {
+    int key;
+    int payload[15];
+};
+
+struct BenchmarkRecordKey {
+    int operator()(const BenchmarkRecord& record) const { return record.key; }
+};
+
+// Wrapper functions (the engines themselves live in sort_engines.h)
+void sequentialSort(std::span<int> numbers) {
+    std::sort(numbers.begin(), numbers.end());
+}
 
-const int SMALL_ARRAY_THRESHOLD = 1000;
-const int SEQUENTIAL_THRESHOLD = 1000;
+void sequentialQuickSortEngine(std::span<int> numbers) {
+    sequentialQuickSort(numbers.data(), 0, numbers.size() - 1);
+}
 
-// Sequential QuickSort implementation
-void sequentialQuickSort(std::vector<int>& arr, int left, int right) {
-    if (left < right) {
-        int pivot = arr[right];
-        int i = left - 1;
+void optimizedParallelSort(std::span<int> numbers) {
+    optimizedTaskQuickSort(numbers.data(), numbers.size());
+}
 
-        for (int j = left; j < right; j++) {
-            if (arr[j] <= pivot) {
-                i++;
-                std::swap(arr[i], arr[j]);
-            }
-        }
-        std::swap(arr[i + 1], arr[right]);
+void parallelOptimizedSort(std::span<int> numbers) {
+    parallelTaskQuickSort(numbers.data(), numbers.size());
+}
 
-        int partition = i + 1;
-        sequentialQuickSort(arr, left, partition - 1);
-        sequentialQuickSort(arr, partition + 1, right);
+// Quicksort task for the work-stealing scheduler (see work_stealing.h). Same
+// cutoff and leaf engine as optimizedParallelQuickSort, but the task keeps the
+// left part for itself and spawns the right part, and never waits for it.
+class WsQuickSortTask : public WsTask {
+public:
+    WsQuickSortTask(int* arr, int left, int right) : arr_(arr), left_(left), right_(right) {}
+
+    void execute(WsWorker& worker) override {
+        while (right_ - left_ > sortTuning().smallArrayThreshold) {
+            PartitionBounds bounds = simdPartitionRange(arr_, left_, right_);
+            worker.spawn(this, new WsQuickSortTask(arr_, bounds.gt + 1, right_));
+            right_ = bounds.lt - 1;
+        }
+        sortLeaf(arr_, left_, right_);
     }
+
+private:
+    int* arr_;
+    int left_;
+    int right_;
+};
+
+// Persistent scheduler shared by every workStealingSort call, created in main
+WorkStealingPool* workStealingPool = nullptr;
+
+void workStealingSort(std::span<int> numbers) {
+    workStealingPool->run(new WsQuickSortTask(numbers.data(), 0, numbers.size() - 1));
 }
 
-// Optimized Parallel QuickSort implementation
-void optimizedParallelQuickSort(std::vector<int>& arr, int left, int right) {
-    if (right - left <= SMALL_ARRAY_THRESHOLD) {
-        sequentialQuickSort(arr, left, right);
-    } else if (left < right) {
-        int pivot = arr[right];
-        int i = left - 1;
+// Reusable context shared by every sortContextSort call, created in main
+SortContext* sortContext = nullptr;
 
-        for (int j = left; j < right; j++) {
-            if (arr[j] <= pivot) {
-                i++;
-                std::swap(arr[i], arr[j]);
-            }
-        }
-        std::swap(arr[i + 1], arr[right]);
+// Multiway mergesort on the context's warm, pinned workers, see sort_context.h
+void sortContextSort(std::span<int> numbers) {
+    sortContext->sort(numbers);
+}
 
-        int partition = i + 1;
+// Scratch of numaMergeSort, first-touched in the engines' static partition
+// and created in main
+NumaBuffer<int>* numaScratch = nullptr;
 
-        #pragma omp task shared(arr)
-        optimizedParallelQuickSort(arr, left, partition - 1);
+// Per-node sort-then-merge, see numa_buffer.h
+void numaMergeSort(std::span<int> numbers) {
+    numaSortThenMerge(numbers.data(), numbers.size(), numaScratch->data());
+}
 
-        #pragma omp task shared(arr)
-        optimizedParallelQuickSort(arr, partition + 1, right);
+// LSD radix sort (counting sort for small key ranges), see radix_sort.h
+void radixSort(std::span<int> numbers) {
+    parallelRadixSort(numbers.data(), numbers.size());
+}
 
-        #pragma omp taskwait  // Ensure that tasks complete before proceeding
-    }
+// Chunked std::sort followed by a splitter-based multiway merge, see merge_sort.h
+void multiwayMergeSort(std::span<int> numbers) {
+    parallelMultiwayMergeSort(numbers.data(), numbers.size());
 }
 
-// Parallel QuickSort implementation with improved synchronization
-void parallelQuickSort(std::vector<int>& arr, int low, int high, int depth) {
-    if (high - low < SEQUENTIAL_THRESHOLD || depth > 3) {
-        sequentialQuickSort(arr, low, high);
+// Placement of the benchmark's buffers, set with --numa
+NumaPlacement benchmarkPlacement = NumaPlacement::FirstTouch;
+
+// Oversampling factor for sampleSort, set with --oversampling
+int sampleSortOversampling = SAMPLE_SORT_OVERSAMPLING;
+
+// PSRS-style sample sort with one bucket per thread, see sample_sort.h
+void sampleSort(std::span<int> numbers) {
+    parallelSampleSort(numbers.data(), numbers.size(), sampleSortOversampling);
+}
+
+// Helper function to generate random numbers: elements firstIndex onwards
+// of the Philox stream for seed (see random_engine.h)
+std::vector<int> generateRandomVector(int size, uint64_t seed, long long firstIndex = 0) {
+    std::vector<int> vec(size);
+    fillRandomParallel(vec.data(), size, 1, 1000000, seed, firstIndex);
+    return vec;
+}
+
+// Writes the benchmark input for (distribution, size, seed) to input[0, size)
+// from random_numbers_<size>_<seed>.bin (or <distribution>_numbers_<size>_<seed>.bin
+// for the other distributions), generating it in place and writing the file
+// first if it does not exist yet. The data is the same generateDistribution()
+// input the runs without --binary sort, so later runs with the same seed (by
+// default BINARY_INPUT_DEFAULT_SEED) map the file and copy it straight into
+// input instead of regenerating it.
+void loadOrGenerateBinaryInput(int* input, int size, InputDistribution distribution, uint64_t seed) {
+    std::string prefix = distribution == InputDistribution::Uniform ? "random" : distributionName(distribution);
+    std::string filename = prefix + "_numbers_" + std::to_string(size) + "_" + std::to_string(seed) + ".bin";
+    if (!isBinaryFile(filename.c_str())) {
+        generateDistribution(distribution, input, size, seed);
+        writeBinaryFile(filename.c_str(), input, size, false);
         return;
     }
 
-    int pivot = arr[high];
-    int i = low - 1;
-
-    for (int j = low; j < high; j++) {
-        if (arr[j] <= pivot) {
-            i++;
-            std::swap(arr[i], arr[j]);
-        }
+    MappedBinaryFile cached(filename.c_str());
+    if (cached.size() != size) {
+        std::cerr << "Error: " << filename << " holds " << cached.size() << " values instead of " << size << std::endl;
+        exit(1);
     }
-    std::swap(arr[i + 1], arr[high]);
+    parallelCopy(input, cached.data(), size);
+}
 
-    int pi = i + 1;
+// Function to measure execution time of a sorting function (on the monotonic clock)
+double measureExecutionTime(void (*sortFunction)(std::span<int>), std::span<int> numbers) {
+    auto start = std::chrono::steady_clock::now();
+    sortFunction(numbers);
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
 
-    #pragma omp task shared(arr) if(depth <= 3)
-    parallelQuickSort(arr, low, pi - 1, depth + 1);
+// Sort engine as it appears in the reports
+struct BenchmarkEngine {
+    const char* label;          // report column prefix ("<label> Time") and JSON engine name
+    const char* name;           // console name
+    const char* speedupColumn;  // nullptr for the baseline
+    void (*sort)(std::span<int>);
+};
+
+// Median time of sortFunction over reps fresh copies of input
+double medianTimeOnCopies(void (*sortFunction)(std::span<int>), const std::vector<int>& input, int reps) {
+    std::vector<double> times;
+    for (int r = 0; r < reps; r++) {
+        std::vector<int> copy = input;
+        times.push_back(measureExecutionTime(sortFunction, copy));
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
 
-    #pragma omp task shared(arr) if(depth <= 3)
-    parallelQuickSort(arr, pi + 1, high, depth + 1);
+// Sets *parameter to each candidate in turn and keeps the fastest
+void sweepParameter(const char* name, int* parameter, const std::vector<int>& candidates,
+                    void (*sortFunction)(std::span<int>), const std::vector<int>& calibration) {
+    int best = *parameter;
+    double bestTime = medianTimeOnCopies(sortFunction, calibration, 3);
+    for (int candidate : candidates) {
+        *parameter = candidate;
+        double time = medianTimeOnCopies(sortFunction, calibration, 3);
+        if (time < bestTime) {
+            bestTime = time;
+            best = candidate;
+        }
+    }
+    *parameter = best;
+    std::cout << "Tuned " << name << " = " << best << " (" << bestTime << " seconds)" << std::endl;
+}
 
-    #pragma omp taskwait  // Ensure that tasks complete before proceeding
+// Sweeps the insertion-sort leaf size, the sequential cutoffs and the task
+// depth one after another on a calibration array, then saves the result as
+// the profile for this host
+void runAutoTuning(const std::string& profilePath, uint64_t seed) {
+    std::vector<int> calibration = generateRandomVector(TUNING_CALIBRATION_SIZE, seed);
+    SortTuning& tuning = sortTuning();
+    const std::vector<int> cutoffs = {250, 500, 1000, 2000, 4000, 8000, 16000, 32000};
+
+    sweepParameter("insertion_sort_threshold", &tuning.insertionSortThreshold, {0, 8, 16, 24, 32, 48, 64},
+                   sequentialQuickSortEngine, calibration);
+    sweepParameter("small_array_threshold", &tuning.smallArrayThreshold, cutoffs,
+                   optimizedParallelSort, calibration);
+    sweepParameter("sequential_threshold", &tuning.sequentialThreshold, cutoffs,
+                   parallelOptimizedSort, calibration);
+    sweepParameter("max_task_depth", &tuning.maxTaskDepth, {1, 2, 3, 4, 5, 6, 8, 10},
+                   parallelOptimizedSort, calibration);
+
+    saveTuningProfile(profilePath, tuning);
+    std::cout << "Tuning profile has been written to " << profilePath << std::endl;
 }
 
-void parallelSort(std::vector<int>& arr) {
-    #pragma omp parallel
-    {
-        #pragma omp single nowait
-        parallelQuickSort(arr, 0, arr.size() - 1, 0);
+// Sorts a batch of many independent arrays once per array through
+// optimizedParallelSort and once with a single sortBatch call (using the same
+// leaf engine), and reports the throughput of both
+void runBatchBenchmark(uint64_t seed) {
+    // Log-uniform sizes from a second Philox stream; the arrays take
+    // consecutive pieces of the key stream
+    const double logMin = std::log(BATCH_BENCHMARK_MIN_SIZE), logMax = std::log(BATCH_BENCHMARK_MAX_SIZE);
+    std::vector<std::vector<int>> batch(BATCH_BENCHMARK_ARRAYS);
+    long long totalKeys = 0;
+    for (int i = 0; i < BATCH_BENCHMARK_ARRAYS; i++) {
+        double u = (philox4x32(static_cast<uint64_t>(i), ~seed).v[0] + 0.5) / 4294967296.0;
+        batch[i] = generateRandomVector(static_cast<int>(std::exp(logMin + u * (logMax - logMin))), seed, totalKeys);
+        totalKeys += batch[i].size();
+    }
+
+    std::vector<std::vector<int>> perCall = batch;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (std::vector<int>& array : perCall) optimizedParallelSort(array);
+    double perCallTime = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+    std::vector<std::vector<int>> batched = batch;
+    std::vector<std::span<int>> spans(batched.begin(), batched.end());
+    start = std::chrono::high_resolution_clock::now();
+    sortBatch(spans, sortLeaf);
+    double batchTime = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+    if (perCall != batched) {
+        std::cerr << "Error: Batch sort produced incorrect results" << std::endl;
+        exit(1);
     }
+
+    std::cout << "Batch of " << BATCH_BENCHMARK_ARRAYS << " arrays (" << totalKeys << " keys)" << std::endl;
+    std::cout << "One call per array: " << perCallTime << " seconds, " << BATCH_BENCHMARK_ARRAYS / perCallTime << " arrays/s" << std::endl;
+    std::cout << "Single batch call: " << batchTime << " seconds, " << BATCH_BENCHMARK_ARRAYS / batchTime << " arrays/s" << std::endl;
+    std::cout << "Batch speedup: " << perCallTime / batchTime << std::endl;
 }
 
-// Wrapper functions
-void sequentialSort(std::vector<int>& numbers) {
-    std::sort(numbers.begin(), numbers.end());
+// True if records are in key order and every payload still matches its key
+bool recordsSortedAndIntact(const std::vector<BenchmarkRecord>& records) {
+    for (size_t i = 0; i < records.size(); i++) {
+        if (i > 0 && records[i - 1].key > records[i].key) return false;
+        for (int j = 0; j < 15; j++) {
+            if (records[i].payload[j] != records[i].key + j) return false;
+        }
+    }
+    return true;
 }
 
-void optimizedParallelSort(std::vector<int>& numbers) {
-    #pragma omp parallel
-    {
-        #pragma omp single
-        optimizedParallelQuickSort(numbers, 0, numbers.size() - 1);
+// Sorts 64-byte records by key by moving whole records (quicksort and radix)
+// and through packed key|index words plus one gather, and reports the times
+void runRecordBenchmark(uint64_t seed) {
+    std::vector<int> keys = generateRandomVector(RECORD_BENCHMARK_SIZE, seed);
+    std::vector<BenchmarkRecord> records(RECORD_BENCHMARK_SIZE);
+    for (int i = 0; i < RECORD_BENCHMARK_SIZE; i++) {
+        records[i].key = keys[i];
+        for (int j = 0; j < 15; j++) records[i].payload[j] = keys[i] + j;
+    }
+    struct Variant {
+        const char* name;
+        void (*sort)(std::vector<BenchmarkRecord>&);
+    };
+    const Variant variants[] = {
+        {"Record quicksort", [](std::vector<BenchmarkRecord>& r) {
+            parallelQuickSortBy(r.data(), static_cast<int>(r.size()), BenchmarkRecordKey());
+        }},
+        {"Record radix sort", [](std::vector<BenchmarkRecord>& r) {
+            parallelRadixSortBy(r.data(), static_cast<long long>(r.size()), BenchmarkRecordKey());
+        }},
+        {"Packed key|index sort", [](std::vector<BenchmarkRecord>& r) {
+            sortByPackedKeys(r.data(), static_cast<int>(r.size()), BenchmarkRecordKey());
+        }},
+    };
+
+    std::cout << "Sorting " << RECORD_BENCHMARK_SIZE << " records of " << sizeof(BenchmarkRecord) << " bytes" << std::endl;
+    for (const Variant& variant : variants) {
+        std::vector<BenchmarkRecord> copy = records;
+        auto start = std::chrono::high_resolution_clock::now();
+        variant.sort(copy);
+        double time = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        if (!recordsSortedAndIntact(copy)) {
+            std::cerr << "Error: " << variant.name << " produced incorrect results" << std::endl;
+            exit(1);
+        }
+        std::cout << variant.name << " time: " << time << " seconds" << std::endl;
     }
 }
 
-void parallelOptimizedSort(std::vector<int>& numbers) {
-    parallelSort(numbers);
+// Engines in report order; the first one is the speedup baseline
+const BenchmarkEngine BENCHMARK_ENGINES[] = {
+    {"Sequential", "Sequential", nullptr, sequentialSort},
+    {"Parallel", "Parallel", "Parallel Speedup", parallelOptimizedSort},
+    {"Optimized Parallel", "Optimized parallel", "Optimized Speedup", optimizedParallelSort},
+    {"Radix", "Radix", "Radix Speedup", radixSort},
+    {"Merge Sort", "Merge sort", "Merge Sort Speedup", multiwayMergeSort},
+    {"Sample Sort", "Sample sort", "Sample Sort Speedup", sampleSort},
+    {"Work-Stealing", "Work-stealing", "Work-Stealing Speedup", workStealingSort},
+    {"Sort Context", "Sort context", "Sort Context Speedup", sortContextSort},
+    {"NUMA Merge", "NUMA merge", "NUMA Merge Speedup", numaMergeSort},
+};
+
+const int NUM_BENCHMARK_ENGINES = sizeof(BENCHMARK_ENGINES) / sizeof(BENCHMARK_ENGINES[0]);
+
+// "Radix Speedup" -> "Radix Efficiency"
+std::string efficiencyColumn(const BenchmarkEngine& engine) {
+    std::string column = engine.speedupColumn;
+    return column.substr(0, column.size() - std::strlen("Speedup")) + "Efficiency";
 }
 
-// Helper function to generate random numbers
-std::vector<int> generateRandomVector(int size) {
-    std::vector<int> vec(size);
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dis(1, 1000000);
+// Times every engine on the first size keys of arena.master(): warmup runs
+// come first, and the engines then take turns within every repetition, each
+// run on a working buffer refreshed from the master. Counters, when given,
+// are read around the timed call only.
+std::vector<BenchmarkResult> benchmarkInput(BenchmarkArena& arena, int size, InputDistribution distribution,
+                                            int repetitions, int warmups, PerfCounters* counters) {
+    arena.prepare(size);
+
+    auto runOnce = [&](const BenchmarkEngine& engine, CounterSample* sample) {
+        std::span<int> work = arena.refresh(size);
+        if (sample != nullptr) counters->start();
+        double time = measureExecutionTime(engine.sort, work);
+        if (sample != nullptr) *sample = counters->stop(time);
+        if (!arena.matches(size)) {
+            std::cerr << "Error: " << engine.name << " sort produced incorrect results for size " << size
+                      << " (" << distributionName(distribution) << ")" << std::endl;
+            exit(1);
+        }
+        return time;
+    };
 
-    for (int& num : vec) {
-        num = dis(gen);
+    for (int w = 0; w < warmups; w++) {
+        for (const BenchmarkEngine& engine : BENCHMARK_ENGINES) runOnce(engine, nullptr);
     }
-    return vec;
+    if (counters != nullptr) counters->refreshThreads();
+    std::vector<std::vector<double>> samples(NUM_BENCHMARK_ENGINES);
+    std::vector<std::vector<CounterSample>> counterSamples(NUM_BENCHMARK_ENGINES, std::vector<CounterSample>(repetitions));
+    for (int r = 0; r < repetitions; r++) {
+        for (int e = 0; e < NUM_BENCHMARK_ENGINES; e++) {
+            samples[e].push_back(runOnce(BENCHMARK_ENGINES[e], counters != nullptr ? &counterSamples[e][r] : nullptr));
+        }
+    }
+
+    std::vector<BenchmarkResult> row;
+    for (int e = 0; e < NUM_BENCHMARK_ENGINES; e++) {
+        BenchmarkResult result;
+        result.engine = BENCHMARK_ENGINES[e].label;
+        result.distribution = distributionName(distribution);
+        result.size = size;
+        result.samples = samples[e];
+        result.summary = summarizeSamples(samples[e]);
+        row.push_back(result);
+        row[e].speedup = row[0].summary.median / row[e].summary.median;
+        if (counters != nullptr) {
+            // Counters of the run whose time is the (upper) median
+            std::vector<int> order(repetitions);
+            std::iota(order.begin(), order.end(), 0);
+            std::sort(order.begin(), order.end(), [&](int a, int b) { return samples[e][a] < samples[e][b]; });
+            row[e].hasCounters = true;
+            row[e].counters = counterSamples[e][order[repetitions / 2]];
+        }
+    }
+    return row;
 }
 
-// Function to measure execution time of a sorting function
-double measureExecutionTime(void (*sortFunction)(std::vector<int>&), std::vector<int>& numbers) {
-    auto start = std::chrono::high_resolution_clock::now();
-    sortFunction(numbers);
-    auto end = std::chrono::high_resolution_clock::now();
-    return std::chrono::duration<double>(end - start).count();
+// Median time of one engine at one point of a --scaling sweep
+struct ScalingPoint {
+    std::string bind;
+    int threads;
+    int size;
+    std::string engine;
+    double median;
+    double ciLow;
+    double ciHigh;
+};
+
+std::string shellQuote(const std::string& text) {
+    std::string quoted = "'";
+    for (char c : text) quoted += c == '\'' ? std::string("'\\''") : std::string(1, c);
+    return quoted + "'";
 }
 
-int main() {
-    srand(time(nullptr));  // Seed the random number generator
+// Median of engine at (bind, threads, size), or 0 if that point was not measured
+double scalingMedian(const std::vector<ScalingPoint>& points, const std::string& bind, int threads,
+                     int size, const std::string& engine) {
+    for (const ScalingPoint& point : points) {
+        if (point.bind == bind && point.threads == threads && point.size == size && point.engine == engine) {
+            return point.median;
+        }
+    }
+    return 0;
+}
 
-    std::vector<int> inputSizes = {10000, 100000, 1000000, 10000000};
-    int numRuns = 5;
+// Strong and weak scaling sweep. OMP_PROC_BIND and OMP_PLACES are only read
+// when the OpenMP runtime starts, so every (policy, thread count) point runs
+// in a fresh process: this binary re-executed with the same arguments plus
+// --scaling-child, --seed, OMP_NUM_THREADS, OMP_PROC_BIND and OMP_PLACES set,
+// which reports its medians on stdout. Strong scaling keeps the --sizes inputs;
+// weak scaling sorts weakSize keys per thread. Writes scaling_report.csv.
+void runScalingSweep(int argc, char* argv[], const std::vector<int>& strongSizes, const std::vector<int>& threadCounts,
+                     const std::vector<std::string>& bindPolicies, const std::string& places, int weakSize,
+                     uint64_t seed) {
+    char self[4096];
+    ssize_t length = readlink("/proc/self/exe", self, sizeof(self) - 1);
+    if (length <= 0) {
+        std::cerr << "Error resolving /proc/self/exe" << std::endl;
+        exit(1);
+    }
+    self[length] = '\0';
+
+    std::vector<ScalingPoint> points;
+    for (const std::string& bind : bindPolicies) {
+        for (int threads : threadCounts) {
+            std::vector<int> sizes = strongSizes;
+            long long weakTotal = static_cast<long long>(weakSize) * threads;
+            if (weakTotal <= INT_MAX) sizes.push_back(static_cast<int>(weakTotal));
+            std::sort(sizes.begin(), sizes.end());
+            sizes.erase(std::unique(sizes.begin(), sizes.end()), sizes.end());
+
+            std::ostringstream commandText;
+            commandText << "env OMP_NUM_THREADS=" << threads << " OMP_PROC_BIND=" << shellQuote(bind)
+                        << " OMP_PLACES=" << shellQuote(places) << " " << shellQuote(self);
+            for (int a = 1; a < argc; a++) commandText << " " << shellQuote(argv[a]);
+            commandText << " --scaling-child --seed " << seed << " --sizes ";
+            for (size_t i = 0; i < sizes.size(); i++) commandText << (i == 0 ? "" : ",") << sizes[i];
+            const std::string command = commandText.str();
+
+            std::cout << "Running " << threads << " threads, OMP_PROC_BIND=" << bind << std::endl;
+            FILE* child = popen(command.c_str(), "r");
+            if (child == nullptr) {
+                std::cerr << "Error running: " << command << std::endl;
+                exit(1);
+            }
+            char line[512];
+            while (std::fgets(line, sizeof(line), child) != nullptr) {
+                char engine[128];
+                int size;
+                double median, ciLow, ciHigh;
+                if (std::sscanf(line, "SCALING\t%127[^\t]\t%d\t%lf\t%lf\t%lf", engine, &size, &median, &ciLow, &ciHigh) == 5) {
+                    points.push_back({bind, threads, size, engine, median, ciLow, ciHigh});
+                }
+            }
+            if (pclose(child) != 0) {
+                std::cerr << "Error: scaling run failed: " << command << std::endl;
+                exit(1);
+            }
+        }
+    }
 
-    std::ofstream reportFile("complete_performance_report.csv");
-    reportFile << "Input Size,Sequential Time,Parallel Time,Optimized Parallel Time,Parallel Speedup,Optimized Speedup" << std::endl;
+    // Speedup is against the sequential engine at the same point, efficiency
+    // is speedup / threads, and scaling efficiency compares the engine with
+    // its own single-thread run: T(1) / (p * T(p)) for strong scaling and
+    // T(1) / T(p) for weak scaling (left empty without a 1-thread run)
+    std::ofstream reportFile("scaling_report.csv");
+    reportFile << "Scaling,Bind,Places,Threads,Input Size,Engine,Median Time,CI Low,CI High,"
+               << "Speedup,Efficiency,Scaling Efficiency" << std::endl;
+    for (const ScalingPoint& point : points) {
+        bool strong = std::find(strongSizes.begin(), strongSizes.end(), point.size) != strongSizes.end();
+        bool weak = static_cast<long long>(weakSize) * point.threads == point.size;
+        double sequential = scalingMedian(points, point.bind, point.threads, point.size, BENCHMARK_ENGINES[0].label);
+        double speedup = sequential / point.median;
+
+        for (int mode = 0; mode < 2; mode++) {
+            if ((mode == 0 && !strong) || (mode == 1 && !weak)) continue;
+            double single = scalingMedian(points, point.bind, 1, mode == 0 ? point.size : weakSize, point.engine);
+            reportFile << (mode == 0 ? "strong" : "weak") << "," << point.bind << "," << places << ","
+                       << point.threads << "," << point.size << "," << point.engine << "," << point.median << ","
+                       << point.ciLow << "," << point.ciHigh << "," << speedup << "," << speedup / point.threads << ",";
+            if (single > 0) reportFile << (mode == 0 ? single / (point.threads * point.median) : single / point.median);
+            reportFile << std::endl;
+        }
+    }
+    reportFile.close();
+    std::cout << "Scaling report has been written to scaling_report.csv" << std::endl;
+}
 
-    for (int size : inputSizes) {
-        double seqTotalTime = 0, parTotalTime = 0, optParTotalTime = 0;
+// Median sort time of the distributed sample sort at one (ranks, threads) point
+struct DistributedPoint {
+    int ranks;
+    int threads;
+    long long size;
+    SampleSummary summary;
+};
+
+// Hybrid MPI+OpenMP sweep: every (ranks, threads per rank) point runs
+// distributed_sample_sort through mpirun, repetitions times, on generated
+// uniform keys without writing the output, and collects the sort times it
+// reports (from the local sort through the merge). Strong scaling keeps the
+// --sizes inputs; weak scaling sorts weakSize keys per core (rank x thread).
+// Scaling efficiency is against the 1 rank x 1 thread point, as in
+// runScalingSweep. Spread the ranks over nodes through the launcher, e.g.
+// --mpirun "mpirun --hostfile hosts -x OMP_NUM_THREADS". Writes
+// distributed_scaling_report.csv.
+void runDistributedSweep(const std::vector<int>& strongSizes, const std::vector<int>& rankCounts,
+                         const std::vector<int>& threadCounts, int weakSize, int repetitions,
+                         const std::string& mpirun, const std::string& program) {
+    std::vector<DistributedPoint> points;
+    for (int ranks : rankCounts) {
+        for (int threads : threadCounts) {
+            std::vector<long long> sizes(strongSizes.begin(), strongSizes.end());
+            sizes.push_back(static_cast<long long>(weakSize) * ranks * threads);
+            std::sort(sizes.begin(), sizes.end());
+            sizes.erase(std::unique(sizes.begin(), sizes.end()), sizes.end());
+
+            for (long long size : sizes) {
+                std::ostringstream commandText;
+                commandText << "env OMP_NUM_THREADS=" << threads << " " << mpirun << " -np " << ranks << " "
+                            << shellQuote(program) << " --generate " << size << " --max-value " << DISTRIBUTION_MAX_VALUE
+                            << " --no-output --tabular";
+                const std::string command = commandText.str();
+                std::cout << "Running " << ranks << " ranks x " << threads << " threads, " << size << " keys" << std::endl;
+
+                std::vector<double> samples;
+                for (int r = 0; r < repetitions; r++) {
+                    FILE* child = popen(command.c_str(), "r");
+                    if (child == nullptr) {
+                        std::cerr << "Error running: " << command << std::endl;
+                        exit(1);
+                    }
+                    char line[512];
+                    while (std::fgets(line, sizeof(line), child) != nullptr) {
+                        int reportedRanks, reportedThreads;
+                        long long values;
+                        double sortTime, totalTime;
+                        if (std::sscanf(line, "DISTRIBUTED\t%d\t%d\t%lld\t%lf\t%lf", &reportedRanks, &reportedThreads,
+                                        &values, &sortTime, &totalTime) == 5) {
+                            samples.push_back(sortTime);
+                        }
+                    }
+                    if (pclose(child) != 0 || samples.size() != static_cast<size_t>(r + 1)) {
+                        std::cerr << "Error: distributed run failed: " << command << std::endl;
+                        exit(1);
+                    }
+                }
+                points.push_back({ranks, threads, size, summarizeSamples(samples)});
+            }
+        }
+    }
 
-        for (int run = 0; run < numRuns; run++) {
-            std::vector<int> numbers = generateRandomVector(size);
+    auto singleCoreMedian = [&](long long size) {
+        for (const DistributedPoint& point : points) {
+            if (point.ranks == 1 && point.threads == 1 && point.size == size) return point.summary.median;
+        }
+        return 0.0;
+    };
+
+    // Speedup is T(1 x 1) / T on the same input for strong scaling and the
+    // scaled speedup cores * T(1 x 1) / T for weak scaling; either way the
+    // scaling efficiency is speedup / cores (left empty without a 1 x 1 run)
+    std::ofstream reportFile("distributed_scaling_report.csv");
+    reportFile << "Scaling,Ranks,Threads per Rank,Cores,Input Size,Median Time,CI Low,CI High,"
+               << "Speedup,Scaling Efficiency" << std::endl;
+    for (const DistributedPoint& point : points) {
+        const int cores = point.ranks * point.threads;
+        bool strong = std::find(strongSizes.begin(), strongSizes.end(), point.size) != strongSizes.end();
+        bool weak = static_cast<long long>(weakSize) * cores == point.size;
+
+        for (int mode = 0; mode < 2; mode++) {
+            if ((mode == 0 && !strong) || (mode == 1 && !weak)) continue;
+            double single = singleCoreMedian(mode == 0 ? point.size : weakSize);
+            const SampleSummary& s = point.summary;
+            reportFile << (mode == 0 ? "strong" : "weak") << "," << point.ranks << "," << point.threads << "," << cores
+                       << "," << point.size << "," << s.median << "," << s.ciLow << "," << s.ciHigh << ",";
+            if (single > 0) {
+                double speedup = (mode == 0 ? single : cores * single) / s.median;
+                reportFile << speedup << "," << speedup / cores;
+            } else {
+                reportFile << ",";
+            }
+            reportFile << std::endl;
+        }
+    }
+    reportFile.close();
+    std::cout << "Distributed scaling report has been written to distributed_scaling_report.csv" << std::endl;
+}
 
-            std::vector<int> seqNumbers = numbers;
-            std::vector<int> parNumbers = numbers;
-            std::vector<int> optParNumbers = numbers;
+// Runs the two OpenMP task quicksorts once per size with tracing on and
+// writes all of their task events to one Chrome trace at path
+void runTraceCapture(const char* path, const std::vector<int>& sizes, InputDistribution distribution, uint64_t seed) {
+    struct TracedEngine {
+        const char* name;
+        void (*sort)(std::span<int>);
+    };
+    const TracedEngine engines[] = {
+        {"Parallel", parallelOptimizedSort},
+        {"Optimized parallel", optimizedParallelSort},
+    };
+
+    enableTracing();
+    for (int size : sizes) {
+        std::vector<int> input = generateDistribution(distribution, size, seed);
+        const uint64_t checksum = binaryChecksum(input.data(), size);
+        for (const TracedEngine& engine : engines) {
+            std::vector<int> work = input;
+            {
+                TraceScope trace(TraceKind::Sort, 0, size - 1, 0, engine.name);
+                engine.sort(work);
+            }
+            SortVerifier verifier = verifySorted(work.data(), size);
+            if (!verifier.sorted() || verifier.checksum() != checksum) {
+                std::cerr << "Error: " << engine.name << " sort produced incorrect results for size " << size << std::endl;
+                exit(1);
+            }
+        }
+    }
+    disableTracing();
 
-            seqTotalTime += measureExecutionTime(sequentialSort, seqNumbers);
-            parTotalTime += measureExecutionTime(parallelOptimizedSort, parNumbers);
-            optParTotalTime += measureExecutionTime(optimizedParallelSort, optParNumbers);
+    writeChromeTrace(path);
+    std::cout << "Task trace has been written to " << path << std::endl;
+}
 
-            if (!std::equal(seqNumbers.begin(), seqNumbers.end(), parNumbers.begin())) {
-                std::cerr << "Error: Parallel sort produced incorrect results for size " << size << std::endl;
-                return 1;
+int main(int argc, char* argv[]) {
+    // --binary reuses inputs cached in the binary format (see binary_io.h),
+    // --seed S seeds every generated input, including those of --tune, --batch, --records and --trace
+    // (default: random, or BINARY_INPUT_DEFAULT_SEED with --binary; printed at start),
+    // --oversampling N sets the sample sort's oversampling factor,
+    // --tune recalibrates the engine cutoffs and saves them (see sort_tuning.h),
+    // --profile PATH overrides the per-host profile location,
+    // --simd scalar|avx2|avx512 caps the kernel set (default: best available),
+    // --leaf quicksort|block|std picks the parallel quicksorts' leaf engine,
+    // --batch only runs the many-small-arrays benchmark (see batch_sort.h),
+    // --records only runs the record sorting benchmark (see record_sort.h),
+    // --sizes N1,N2,... --reps R --warmups W shape the benchmark (see benchmark_harness.h),
+    // --distributions D1,D2,... picks the input distributions (see input_distributions.h),
+    // --counters adds hardware counters and busy/idle times to the reports (see perf_counters.h),
+    // --numa first-touch|interleave places the working buffers' pages over the NUMA nodes (see numa_buffer.h),
+    // --trace PATH only records one traced run of the task quicksorts per size (see task_trace.h),
+    // --scaling sweeps --threads N1,N2,... under each --bind P1,P2,... (OMP_PROC_BIND values)
+    // with OMP_PLACES=--places, for the --sizes inputs and --weak-size keys per thread,
+    // --distributed sweeps --ranks N1,N2,... MPI ranks x --threads of the MPI sample sort,
+    // started with --mpirun CMD (default "mpirun -x OMP_NUM_THREADS") from --mpi-program PATH
+    std::vector<int> inputSizes = {10000, 100000, 1000000, 10000000};
+    std::vector<InputDistribution> distributions(std::begin(ALL_INPUT_DISTRIBUTIONS), std::end(ALL_INPUT_DISTRIBUTIONS));
+    int repetitions = BENCHMARK_DEFAULT_REPETITIONS;
+    int warmups = BENCHMARK_DEFAULT_WARMUPS;
+    bool binaryInputs = false;
+    bool tune = false;
+    bool batch = false;
+    bool recordsOnly = false;
+    bool useCounters = false;
+    const char* tracePath = nullptr;
+    bool scaling = false;
+    bool scalingChild = false;
+    std::vector<int> threadCounts;
+    std::vector<std::string> bindPolicies = {"false", "close", "spread"};
+    std::string places = "cores";
+    int weakSize = SCALING_DEFAULT_WEAK_SIZE;
+    bool distributed = false;
+    std::vector<int> rankCounts = {1, 2, 4};
+    std::string mpirun = DISTRIBUTED_DEFAULT_MPIRUN;
+    std::string mpiProgram = DISTRIBUTED_DEFAULT_PROGRAM;
+    const char* leafEngine = nullptr;
+    std::string profilePath = tuningProfilePath();
+    std::random_device rd;
+    uint64_t seed = (static_cast<uint64_t>(rd()) << 32) | rd();
+    bool seedGiven = false;
+    for (int a = 1; a < argc; a++) {
+        if (std::strcmp(argv[a], "--binary") == 0) binaryInputs = true;
+        else if (std::strcmp(argv[a], "--seed") == 0 && a + 1 < argc) {
+            seed = std::strtoull(argv[++a], nullptr, 10);
+            seedGiven = true;
+        }
+        else if (std::strcmp(argv[a], "--oversampling") == 0 && a + 1 < argc) sampleSortOversampling = std::max(1, std::atoi(argv[++a]));
+        else if (std::strcmp(argv[a], "--tune") == 0) tune = true;
+        else if (std::strcmp(argv[a], "--batch") == 0) batch = true;
+        else if (std::strcmp(argv[a], "--records") == 0) recordsOnly = true;
+        else if (std::strcmp(argv[a], "--counters") == 0) useCounters = true;
+        else if (std::strcmp(argv[a], "--numa") == 0 && a + 1 < argc) {
+            benchmarkPlacement = std::strcmp(argv[++a], "interleave") == 0 ? NumaPlacement::Interleave
+                                                                           : NumaPlacement::FirstTouch;
+        }
+        else if (std::strcmp(argv[a], "--trace") == 0 && a + 1 < argc) tracePath = argv[++a];
+        else if (std::strcmp(argv[a], "--scaling") == 0) scaling = true;
+        else if (std::strcmp(argv[a], "--scaling-child") == 0) scalingChild = true;
+        else if (std::strcmp(argv[a], "--distributed") == 0) distributed = true;
+        else if (std::strcmp(argv[a], "--ranks") == 0 && a + 1 < argc) {
+            rankCounts = parseIntList(argv[++a]);
+            if (rankCounts.empty()) rankCounts.push_back(1);
+        }
+        else if (std::strcmp(argv[a], "--mpirun") == 0 && a + 1 < argc) mpirun = argv[++a];
+        else if (std::strcmp(argv[a], "--mpi-program") == 0 && a + 1 < argc) mpiProgram = argv[++a];
+        else if (std::strcmp(argv[a], "--threads") == 0 && a + 1 < argc) threadCounts = parseIntList(argv[++a]);
+        else if (std::strcmp(argv[a], "--places") == 0 && a + 1 < argc) places = argv[++a];
+        else if (std::strcmp(argv[a], "--weak-size") == 0 && a + 1 < argc) weakSize = std::max(1, std::atoi(argv[++a]));
+        else if (std::strcmp(argv[a], "--bind") == 0 && a + 1 < argc) {
+            bindPolicies.clear();
+            for (const char* policy = std::strtok(argv[++a], ","); policy != nullptr; policy = std::strtok(nullptr, ",")) {
+                bindPolicies.push_back(policy);
+            }
+            if (bindPolicies.empty()) bindPolicies.push_back("false");
+        }
+        else if (std::strcmp(argv[a], "--sizes") == 0 && a + 1 < argc) {
+            std::vector<int> sizes = parseIntList(argv[++a]);
+            if (!sizes.empty()) inputSizes = sizes;
+        }
+        else if (std::strcmp(argv[a], "--distributions") == 0 && a + 1 < argc) {
+            distributions.clear();
+            for (const char* name = std::strtok(argv[++a], ","); name != nullptr; name = std::strtok(nullptr, ",")) {
+                InputDistribution distribution;
+                if (!parseDistribution(name, distribution)) {
+                    std::cerr << "Unknown input distribution: " << name << std::endl;
+                    exit(1);
+                }
+                distributions.push_back(distribution);
             }
+            if (distributions.empty()) distributions.push_back(InputDistribution::Uniform);
+        }
+        else if (std::strcmp(argv[a], "--reps") == 0 && a + 1 < argc) repetitions = std::max(1, std::atoi(argv[++a]));
+        else if (std::strcmp(argv[a], "--warmups") == 0 && a + 1 < argc) warmups = std::max(0, std::atoi(argv[++a]));
+        else if (std::strcmp(argv[a], "--profile") == 0 && a + 1 < argc) profilePath = argv[++a];
+        else if (std::strcmp(argv[a], "--leaf") == 0 && a + 1 < argc) leafEngine = argv[++a];
+        else if (std::strcmp(argv[a], "--simd") == 0 && a + 1 < argc) {
+            const char* level = argv[++a];
+            setSimdLevel(std::strcmp(level, "avx512") == 0 ? SimdLevel::Avx512 :
+                         std::strcmp(level, "avx2") == 0 ? SimdLevel::Avx2 : SimdLevel::Scalar);
+        }
+    }
+    if (binaryInputs && !seedGiven) seed = BINARY_INPUT_DEFAULT_SEED;
+
+    std::cout << "SIMD kernels: " << simdLevelName(activeSimdLevel()) << std::endl;
+    std::cout << "Input seed: " << seed << std::endl;
+
+    if (tune) {
+        runAutoTuning(profilePath, seed);
+    } else if (loadTuningProfile(profilePath, sortTuning())) {
+        std::cout << "Loaded tuning profile " << profilePath << std::endl;
+    }
+    if (leafEngine != nullptr) {
+        sortTuning().leafEngine = parseLeafEngine(leafEngine);
+    }
+    std::cout << "Leaf engine: " << leafEngineName(sortTuning().leafEngine) << std::endl;
+
+    if (batch) {
+        runBatchBenchmark(seed);
+        return 0;
+    }
+    if (recordsOnly) {
+        runRecordBenchmark(seed);
+        return 0;
+    }
+    if (tracePath != nullptr) {
+        runTraceCapture(tracePath, inputSizes, distributions.front(), seed);
+        return 0;
+    }
+    if (threadCounts.empty()) {
+        // Powers of two up to the hardware thread count, and that count itself
+        int hardware = std::max(1u, std::thread::hardware_concurrency());
+        for (int t = 1; t < hardware; t *= 2) threadCounts.push_back(t);
+        threadCounts.push_back(hardware);
+    }
+
+    if (scaling && !scalingChild) {
+        runScalingSweep(argc, argv, inputSizes, threadCounts, bindPolicies, places, weakSize, seed);
+        return 0;
+    }
+    if (distributed) {
+        runDistributedSweep(inputSizes, rankCounts, threadCounts, weakSize, repetitions, mpirun, mpiProgram);
+        return 0;
+    }
 
-            if (!std::equal(seqNumbers.begin(), seqNumbers.end(), optParNumbers.begin())) {
-                std::cerr << "Error: Optimized parallel sort produced incorrect results for size " << size << std::endl;
-                return 1;
+    WorkStealingPool pool(ompMaxThreads());
+    workStealingPool = &pool;
+    SortContext context(ompMaxThreads(), *std::max_element(inputSizes.begin(), inputSizes.end()));
+    sortContext = &context;
+    const int maxSize = *std::max_element(inputSizes.begin(), inputSizes.end());
+    NumaBuffer<int> scratch(maxSize, benchmarkPlacement);
+    numaScratch = &scratch;
+    BenchmarkArena arena(maxSize, benchmarkPlacement);
+
+    if (scalingChild) {
+        // One point of a --scaling sweep: results go to the parent on stdout
+        for (int size : inputSizes) {
+            generateDistribution(distributions.front(), arena.master(), size, seed);
+            for (const BenchmarkResult& result : benchmarkInput(arena, size, distributions.front(), repetitions, warmups, nullptr)) {
+                std::cout << "SCALING\t" << result.engine << "\t" << size << "\t" << result.summary.median
+                          << "\t" << result.summary.ciLow << "\t" << result.summary.ciHigh << std::endl;
             }
         }
+        return 0;
+    }
 
-        double seqAvgTime = seqTotalTime / numRuns;
-        double parAvgTime = parTotalTime / numRuns;
-        double optParAvgTime = optParTotalTime / numRuns;
+    // Opened after the pools so that their workers are counted as well
+    std::unique_ptr<PerfCounters> counters;
+    if (useCounters) {
+        counters = std::make_unique<PerfCounters>();
+        std::cout << "Hardware counters: " << (counters->hardwareAvailable() ? "available" : "unavailable") << std::endl;
+    }
+    std::cout << "Benchmark buffers: " << arena.pageSizeName() << std::endl;
 
-        double parSpeedup = seqAvgTime / parAvgTime;
-        double optParSpeedup = seqAvgTime / optParAvgTime;
+    // The plain columns describe the first distribution of the sweep (uniform
+    // unless --distributions says otherwise); every other distribution adds
+    // one speedup column per parallel engine, such as "Sorted Radix Speedup".
+    // Efficiency is speedup / threads, for the first distribution.
+    std::ofstream reportFile("complete_performance_report.csv");
+    reportFile << "Input Size";
+    for (const BenchmarkEngine& engine : BENCHMARK_ENGINES) reportFile << "," << engine.label << " Time";
+    for (size_t d = 0; d < distributions.size(); d++) {
+        for (const BenchmarkEngine& engine : BENCHMARK_ENGINES) {
+            if (engine.speedupColumn == nullptr) continue;
+            reportFile << "," << (d == 0 ? "" : distributionLabel(distributions[d]) + " ") << engine.speedupColumn;
+        }
+    }
+    for (const BenchmarkEngine& engine : BENCHMARK_ENGINES) {
+        if (engine.speedupColumn != nullptr) reportFile << "," << efficiencyColumn(engine);
+    }
+    if (counters) {
+        // Counters of the base columns' runs, per engine
+        for (const BenchmarkEngine& engine : BENCHMARK_ENGINES) {
+            const std::string prefix = std::string(",") + engine.label + " ";
+            reportFile << prefix << "Cycles" << prefix << "Instructions" << prefix << "LLC Misses"
+                       << prefix << "Branch Misses" << prefix << "Busy Time" << prefix << "Idle Time";
+        }
+    }
+    reportFile << std::endl;
 
-        reportFile << size << ","
-                   << seqAvgTime << ","
-                   << parAvgTime << ","
-                   << optParAvgTime << ","
-                   << parSpeedup << ","
-                   << optParSpeedup << std::endl;
+    const int threads = ompMaxThreads();
+    std::vector<BenchmarkResult> results;
+    for (int size : inputSizes) {
+        std::vector<std::vector<BenchmarkResult>> rows;
+        for (InputDistribution distribution : distributions) {
+            // One input per size and distribution, shared by every engine and repetition
+            if (binaryInputs) {
+                loadOrGenerateBinaryInput(arena.master(), size, distribution, seed);
+            } else {
+                generateDistribution(distribution, arena.master(), size, seed);
+            }
+            std::vector<BenchmarkResult> row = benchmarkInput(arena, size, distribution, repetitions, warmups, counters.get());
+
+            std::cout << "Input size: " << size << ", distribution: " << distributionName(distribution) << std::endl;
+            for (int e = 0; e < NUM_BENCHMARK_ENGINES; e++) {
+                const SampleSummary& summary = row[e].summary;
+                std::cout << BENCHMARK_ENGINES[e].name << " median time: " << summary.median << " seconds (95% CI "
+                          << summary.ciLow << " - " << summary.ciHigh << ", min " << summary.min
+                          << ", p99 " << summary.p99 << ")" << std::endl;
+            }
+            for (int e = 0; e < NUM_BENCHMARK_ENGINES; e++) {
+                if (BENCHMARK_ENGINES[e].speedupColumn != nullptr) {
+                    std::cout << BENCHMARK_ENGINES[e].name << " speedup: " << row[e].speedup
+                              << " (efficiency " << row[e].speedup / threads << ")" << std::endl;
+                }
+            }
+            for (int e = 0; e < NUM_BENCHMARK_ENGINES && counters; e++) {
+                const CounterSample& c = row[e].counters;
+                std::cout << BENCHMARK_ENGINES[e].name << " counters: ";
+                if (c.hardware) {
+                    std::cout << c.cycles << " cycles, " << c.instructions / std::max(1.0, c.cycles) << " IPC, "
+                              << c.llcMisses << " LLC misses, " << c.branchMisses << " branch misses, ";
+                    if (c.unscheduledGroups > 0) std::cout << c.unscheduledGroups << " threads never counted, ";
+                }
+                std::cout << "busy " << c.busy << " s, idle " << c.idle << " s on "
+                          << c.threadBusy.size() << " threads" << std::endl;
+            }
+            std::cout << std::endl;
+            results.insert(results.end(), row.begin(), row.end());
+            rows.push_back(row);
+        }
 
-        std::cout << "Input size: " << size << std::endl;
-        std::cout << "Sequential avg time: " << seqAvgTime << " seconds" << std::endl;
-        std::cout << "Parallel avg time: " << parAvgTime << " seconds" << std::endl;
-        std::cout << "Optimized parallel avg time: " << optParAvgTime << " seconds" << std::endl;
-        std::cout << "Parallel speedup: " << parSpeedup << std::endl;
-        std::cout << "Optimized parallel speedup: " << optParSpeedup << std::endl;
-        std::cout << std::endl;
+        reportFile << size;
+        for (const BenchmarkResult& result : rows[0]) reportFile << "," << result.summary.median;
+        for (const std::vector<BenchmarkResult>& row : rows) {
+            for (int e = 0; e < NUM_BENCHMARK_ENGINES; e++) {
+                if (BENCHMARK_ENGINES[e].speedupColumn != nullptr) reportFile << "," << row[e].speedup;
+            }
+        }
+        for (int e = 0; e < NUM_BENCHMARK_ENGINES; e++) {
+            if (BENCHMARK_ENGINES[e].speedupColumn != nullptr) reportFile << "," << rows[0][e].speedup / threads;
+        }
+        for (const BenchmarkResult& result : rows[0]) {
+            if (!counters) break;
+            const CounterSample& c = result.counters;
+            if (c.hardware) {
+                reportFile << "," << c.cycles << "," << c.instructions << "," << c.llcMisses << "," << c.branchMisses;
+            } else {
+                reportFile << ",,,,";  // no PMU: left empty
+            }
+            reportFile << "," << c.busy << "," << c.idle;
+        }
+        reportFile << std::endl;
     }
 
     reportFile.close();
+    writeBenchmarkJson("complete_performance_report.json", results, repetitions, warmups, threads);
     std::cout << "Performance report has been written to complete_performance_report.csv" << std::endl;
+    std::cout << "Detailed results have been written to complete_performance_report.json" << std::endl;
 
     return 0;
 }
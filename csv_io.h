@@ -0,0 +1,263 @@
+/*
+ * File: csv_io.h
+ *
+ * Description:
+ * Fast CSV input and output for the sorters.
+ *
+ * Reading: the file is memory-mapped and split into one chunk per thread at
+ * separator boundaries. A first pass counts the values in each chunk, a
+ * prefix-sum over those counts gives every chunk its output offset, and a
+ * second pass parses each chunk with a hand-written integer scanner directly
+ * into the destination array. The same two passes run on any buffer already in
+ * memory (parseCsvParallel), such as the byte range one MPI rank has read.
+ *
+ * Writing: the formatted length of every thread's slice is computed up front,
+ * so a prefix-sum gives each thread its byte offset in the file. Each thread
+ * then formats its slice with std::to_chars into a small private buffer and
+ * flushes it with pwrite at that offset; nothing is gathered into one buffer.
+ *
+ * Works with or without OpenMP; without it the chunks are handled in order on
+ * the calling thread.
+ */
+
+#ifndef CSV_IO_H
+#define CSV_IO_H
+
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <charconv>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "omp_compat.h"
+
+inline bool isCsvDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// Counts the integers in [begin, end); a value is a maximal run of digits
+inline long long countCsvValues(const char* begin, const char* end) {
+    long long count = 0;
+    bool inValue = false;
+    for (const char* p = begin; p < end; p++) {
+        bool digit = isCsvDigit(*p);
+        count += digit && !inValue;
+        inValue = digit;
+    }
+    return count;
+}
+
+// Parses up to maxValues integers from [begin, end) into out and returns how
+// many were written. Anything that is not a digit or a leading '-' separates
+// values, so both ',' and line breaks are accepted. If stop is given it
+// receives the position where parsing ended.
+inline long long parseCsvValues(const char* begin, const char* end, int* out, long long maxValues, const char** stop = nullptr) {
+    long long written = 0;
+    const char* p = begin;
+    while (p < end && written < maxValues) {
+        while (p < end && !isCsvDigit(*p) && *p != '-') p++;
+        if (p == end) break;
+
+        bool negative = false;
+        if (*p == '-') {
+            negative = true;
+            p++;
+            if (p == end || !isCsvDigit(*p)) continue;
+        }
+
+        long long value = 0;
+        while (p < end && isCsvDigit(*p)) {
+            value = value * 10 + (*p - '0');
+            p++;
+        }
+        out[written++] = static_cast<int>(negative ? -value : value);
+    }
+    if (stop != nullptr) *stop = p;
+    return written;
+}
+
+// Moves a nominal split position forward to the start of the next value so
+// that no chunk boundary falls inside a number
+inline size_t alignCsvSplit(const char* data, size_t size, size_t pos) {
+    if (pos == 0) return 0;
+    if (pos >= size) return size;
+    while (pos < size && (isCsvDigit(data[pos - 1]) || data[pos - 1] == '-')) pos++;
+    return pos;
+}
+
+// Splits data[0, size) into numChunks chunks at value boundaries; chunk c is
+// [splits[c], splits[c + 1])
+inline std::vector<size_t> csvChunkSplits(const char* data, size_t size, int numChunks) {
+    std::vector<size_t> splits(numChunks + 1);
+    for (int c = 0; c <= numChunks; c++) {
+        splits[c] = alignCsvSplit(data, size, size / numChunks * c);
+    }
+    splits[numChunks] = size;
+    return splits;
+}
+
+// Counts the integers in data[0, size) using one chunk per thread
+inline long long countCsvValuesParallel(const char* data, size_t size) {
+    int numChunks = ompMaxThreads();
+    std::vector<size_t> splits = csvChunkSplits(data, size, numChunks);
+    long long count = 0;
+    #pragma omp parallel for reduction(+:count) schedule(static, 1)
+    for (int c = 0; c < numChunks; c++) {
+        count += countCsvValues(data + splits[c], data + splits[c + 1]);
+    }
+    return count;
+}
+
+// Parses up to N integers from data[0, size) into numbers using one chunk per
+// thread, as described above. Returns the number of values read.
+inline long long parseCsvParallel(const char* data, size_t size, int* numbers, long long N) {
+    if (size == 0 || N <= 0) return 0;
+    int numChunks = ompMaxThreads();
+    std::vector<size_t> splits = csvChunkSplits(data, size, numChunks);
+
+    // Pass 1: count values per chunk, then prefix-sum into output offsets
+    std::vector<long long> offsets(numChunks + 1, 0);
+    #pragma omp parallel for schedule(static, 1)
+    for (int c = 0; c < numChunks; c++) {
+        offsets[c + 1] = countCsvValues(data + splits[c], data + splits[c + 1]);
+    }
+    for (int c = 0; c < numChunks; c++) {
+        offsets[c + 1] += offsets[c];
+    }
+
+    // Pass 2: every chunk parses straight into its slice of numbers
+    #pragma omp parallel for schedule(static, 1)
+    for (int c = 0; c < numChunks; c++) {
+        if (offsets[c] >= N) continue;
+        long long room = N - offsets[c];
+        parseCsvValues(data + splits[c], data + splits[c + 1], numbers + offsets[c], room);
+    }
+    return offsets[numChunks] < N ? offsets[numChunks] : N;
+}
+
+// Reads up to N comma-separated integers from filename into numbers using one
+// chunk per thread. Returns the number of values read.
+inline int readCsvParallel(const char* filename, int* numbers, int N) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        exit(1);
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        std::cerr << "Error reading file: " << filename << std::endl;
+        exit(1);
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    if (size == 0 || N <= 0) {
+        close(fd);
+        return 0;
+    }
+
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Error mapping file: " << filename << std::endl;
+        exit(1);
+    }
+    madvise(mapping, size, MADV_SEQUENTIAL);
+
+    long long count = parseCsvParallel(static_cast<const char*>(mapping), size, numbers, N);
+    munmap(mapping, size);
+    return static_cast<int>(count);
+}
+
+// Size of the per-thread formatting buffer used by writeCsvParallel
+const size_t CSV_WRITE_BUFFER_SIZE = 1 << 20;
+
+// Number of characters std::to_chars produces for value
+inline int formattedLength(int value) {
+    unsigned int magnitude = value < 0 ? 0u - static_cast<unsigned int>(value) : static_cast<unsigned int>(value);
+    int digits = 1;
+    while (magnitude >= 10) {
+        magnitude /= 10;
+        digits++;
+    }
+    return digits + (value < 0);
+}
+
+// Writes all of buffer at file offset, retrying on short writes
+inline void pwriteAll(int fd, const char* buffer, size_t length, off_t offset, const char* filename) {
+    while (length > 0) {
+        ssize_t written = pwrite(fd, buffer, length, offset);
+        if (written < 0) {
+            std::cerr << "Error writing file: " << filename << std::endl;
+            exit(1);
+        }
+        buffer += written;
+        length -= static_cast<size_t>(written);
+        offset += written;
+    }
+}
+
+// Writes numbers[0, N) as a single comma-separated line, one slice per thread
+inline void writeCsvParallel(const char* filename, const int* numbers, int N) {
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        exit(1);
+    }
+    if (N <= 0) {
+        close(fd);
+        return;
+    }
+
+    int numSlices = ompMaxThreads();
+    if (numSlices > N) numSlices = N;
+
+    // Pass 1: formatted byte count of each slice (values plus separators),
+    // prefix-summed into file offsets
+    std::vector<long long> offsets(numSlices + 1, 0);
+    #pragma omp parallel for schedule(static, 1)
+    for (int s = 0; s < numSlices; s++) {
+        long long begin = static_cast<long long>(N) * s / numSlices;
+        long long end = static_cast<long long>(N) * (s + 1) / numSlices;
+        long long bytes = 0;
+        for (long long i = begin; i < end; i++) {
+            bytes += formattedLength(numbers[i]) + 1;
+        }
+        offsets[s + 1] = bytes;
+    }
+    for (int s = 0; s < numSlices; s++) {
+        offsets[s + 1] += offsets[s];
+    }
+    long long totalBytes = offsets[numSlices] - 1;  // no separator after the last value
+    if (ftruncate(fd, totalBytes) != 0) {
+        std::cerr << "Error writing file: " << filename << std::endl;
+        exit(1);
+    }
+
+    // Pass 2: format into a private buffer and pwrite it at the slice offset
+    #pragma omp parallel for schedule(static, 1)
+    for (int s = 0; s < numSlices; s++) {
+        long long begin = static_cast<long long>(N) * s / numSlices;
+        long long end = static_cast<long long>(N) * (s + 1) / numSlices;
+        std::vector<char> buffer(CSV_WRITE_BUFFER_SIZE);
+        char* const bufferEnd = buffer.data() + buffer.size() - 16;
+        char* out = buffer.data();
+        off_t offset = offsets[s];
+
+        for (long long i = begin; i < end; i++) {
+            out = std::to_chars(out, bufferEnd, numbers[i]).ptr;
+            if (i != N - 1) *out++ = ',';
+            if (out >= bufferEnd - 16) {
+                pwriteAll(fd, buffer.data(), out - buffer.data(), offset, filename);
+                offset += out - buffer.data();
+                out = buffer.data();
+            }
+        }
+        pwriteAll(fd, buffer.data(), out - buffer.data(), offset, filename);
+    }
+
+    close(fd);
+}
+
+#endif // CSV_IO_H
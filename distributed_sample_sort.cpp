@@ -0,0 +1,481 @@
+/*
+ * File: distributed_sample_sort.cpp
+ * Compile: mpicxx -O2 -fopenmp distributed_sample_sort.cpp -o distributed_sample_sort
+ * Run: mpirun -np 4 ./distributed_sample_sort [--binary] [--generate N]
+ *
+ * Description:
+ * This program sorts a dataset spread over several nodes with a distributed
+ * sample sort over MPI, using OpenMP inside every rank (hybrid MPI+OpenMP:
+ * typically one rank per node or socket and one thread per core). It
+ * performs the following tasks:
+ * 1. Every rank reads its own byte range of random_numbers.csv with MPI-IO (a
+ *    value belongs to the rank its first character falls in), or its own
+ *    slice of the elements of random_numbers.bin with --binary. With
+ *    --generate N the ranks generate their slices of the Philox stream of
+ *    random_engine.h instead, so no input file is needed.
+ * 2. Sorts its values locally with the parallel radix sort of radix_sort.h.
+ * 3. Takes regular samples of its sorted values; every rank gathers all
+ *    samples and picks the same ranks - 1 splitters. Samples are ordered by
+ *    (value, rank, position), so a long run of equal keys is split between
+ *    ranks instead of landing on a single one.
+ * 4. Exchanges the buckets with MPI_Alltoallv and merges the sorted runs it
+ *    received with the parallel multiway merge of merge_sort.h.
+ * 5. Writes its slice of the output at its offset in sorted_numbers.csv (or
+ *    sorted_numbers.bin) with MPI-IO.
+ * 6. Verifies the result without gathering it (see sort_verify.h): every rank
+ *    checks its own slice, its first value against the last value of the
+ *    ranks before it, and the global checksum is compared with the input's.
+ *
+ * With --tabular the report is a single DISTRIBUTED line (ranks, threads per
+ * rank, values, sort time, total time), as read by the --distributed sweep of
+ * complete_performance_analysis.
+ */
+
+#include <mpi.h>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <ctime>
+#include <charconv>
+#include "random_engine.h"
+#include "csv_io.h"
+#include "binary_io.h"
+#include "radix_sort.h"
+#include "merge_sort.h"
+#include "numa_buffer.h"
+#include "sort_verify.h"
+
+const char* INPUT_FILE = "random_numbers.csv";
+const char* OUTPUT_FILE = "sorted_numbers.csv";
+const char* BINARY_INPUT_FILE = "random_numbers.bin";
+const char* BINARY_OUTPUT_FILE = "sorted_numbers.bin";
+
+// Regular samples each rank contributes to the splitter selection (at least
+// one per rank)
+const int DISTRIBUTED_SAMPLES_PER_RANK = 64;
+
+// Largest piece moved by one MPI-IO call, whose counts are ints
+const long long MPI_IO_CHUNK_BYTES = 1LL << 30;
+
+// Longest formatted int ("-2147483648") plus a separator
+const int CSV_MAX_VALUE_BYTES = 12;
+
+int worldRank = 0;
+int worldSize = 1;
+
+// Set when the MPI library allows calls from any one thread at a time, so
+// that the CSV writer can flush from every OpenMP thread
+bool mpiThreadsSerialized = false;
+
+void abortOnError(const char* message, const char* filename = nullptr) {
+    std::cerr << "Error " << message;
+    if (filename != nullptr) std::cerr << ": " << filename;
+    std::cerr << " (rank " << worldRank << ")" << std::endl;
+    MPI_Abort(MPI_COMM_WORLD, 1);
+}
+
+void readAt(MPI_File file, MPI_Offset offset, char* buffer, long long bytes, const char* filename) {
+    while (bytes > 0) {
+        int piece = static_cast<int>(std::min(bytes, MPI_IO_CHUNK_BYTES));
+        MPI_Status status;
+        int received = 0;
+        if (MPI_File_read_at(file, offset, buffer, piece, MPI_BYTE, &status) != MPI_SUCCESS ||
+            MPI_Get_count(&status, MPI_BYTE, &received) != MPI_SUCCESS || received <= 0) {
+            abortOnError("reading file", filename);
+        }
+        buffer += received;
+        offset += received;
+        bytes -= received;
+    }
+}
+
+void writeAt(MPI_File file, MPI_Offset offset, const char* buffer, long long bytes, const char* filename) {
+    while (bytes > 0) {
+        int piece = static_cast<int>(std::min(bytes, MPI_IO_CHUNK_BYTES));
+        MPI_Status status;
+        int written = 0;
+        if (MPI_File_write_at(file, offset, buffer, piece, MPI_BYTE, &status) != MPI_SUCCESS ||
+            MPI_Get_count(&status, MPI_BYTE, &written) != MPI_SUCCESS || written <= 0) {
+            abortOnError("writing file", filename);
+        }
+        buffer += written;
+        offset += written;
+        bytes -= written;
+    }
+}
+
+MPI_File openFile(const char* filename, int mode) {
+    MPI_File file;
+    if (MPI_File_open(MPI_COMM_WORLD, filename, mode, MPI_INFO_NULL, &file) != MPI_SUCCESS) {
+        abortOnError("opening file", filename);
+    }
+    return file;
+}
+
+// Reads the values whose first character lies in this rank's share of the
+// file's bytes; the splits match those of readCsvParallel (see csv_io.h)
+std::unique_ptr<NumaBuffer<int>> readCsvSlice(const char* filename, long long& count) {
+    MPI_File file = openFile(filename, MPI_MODE_RDONLY);
+    MPI_Offset size;
+    MPI_File_get_size(file, &size);
+    long long begin = size * worldRank / worldSize;
+    long long end = size * (worldRank + 1) / worldSize;
+
+    // The byte before the range tells whether it starts inside a value, and
+    // the bytes after it finish the value that straddles its end
+    long long windowBegin = std::max(0LL, begin - 1);
+    long long windowEnd = std::min<long long>(size, end + CSV_MAX_VALUE_BYTES);
+    std::vector<char> window(windowEnd - windowBegin);
+    readAt(file, windowBegin, window.data(), static_cast<long long>(window.size()), filename);
+    MPI_File_close(&file);
+
+    size_t first = alignCsvSplit(window.data(), window.size(), begin - windowBegin);
+    size_t last = alignCsvSplit(window.data(), window.size(), end - windowBegin);
+    const char* data = window.data() + first;
+    size_t bytes = last > first ? last - first : 0;
+
+    count = countCsvValuesParallel(data, bytes);
+    auto values = std::make_unique<NumaBuffer<int>>(count);
+    parseCsvParallel(data, bytes, values->data(), count);
+    return values;
+}
+
+// Reads this rank's share of the elements of a binary dataset
+std::unique_ptr<NumaBuffer<int>> readBinarySlice(const char* filename, long long& count) {
+    MPI_File file = openFile(filename, MPI_MODE_RDONLY);
+    MPI_Offset size;
+    MPI_File_get_size(file, &size);
+    BinaryHeader header;
+    readAt(file, 0, reinterpret_cast<char*>(&header), sizeof(header), filename);
+    if (!isValidBinaryHeader(header, static_cast<size_t>(size))) {
+        abortOnError("corrupt binary dataset", filename);
+    }
+
+    long long total = static_cast<long long>(header.count);
+    long long first = total * worldRank / worldSize;
+    count = total * (worldRank + 1) / worldSize - first;
+    auto values = std::make_unique<NumaBuffer<int>>(count);
+    readAt(file, sizeof(BinaryHeader) + first * sizeof(int), reinterpret_cast<char*>(values->data()),
+           count * static_cast<long long>(sizeof(int)), filename);
+    MPI_File_close(&file);
+    return values;
+}
+
+// Position of a sample in the global order: equal values are ordered by the
+// rank they come from and then by their position in its sorted slice
+struct SplitterKey {
+    int value;
+    int rank;
+    long long index;
+};
+
+inline bool operator<(const SplitterKey& a, const SplitterKey& b) {
+    if (a.value != b.value) return a.value < b.value;
+    if (a.rank != b.rank) return a.rank < b.rank;
+    return a.index < b.index;
+}
+
+// Gathers regular samples of every rank's sorted slice and returns the same
+// worldSize - 1 splitters on every rank
+std::vector<SplitterKey> selectGlobalSplitters(const int* sorted, long long n) {
+    const int samples = std::max(DISTRIBUTED_SAMPLES_PER_RANK, worldSize);
+    std::vector<SplitterKey> local;
+    for (int s = 0; s < samples && n > 0; s++) {
+        long long i = n * (2LL * s + 1) / (2LL * samples);
+        local.push_back({sorted[i], worldRank, i});
+    }
+
+    int bytes = static_cast<int>(local.size() * sizeof(SplitterKey));
+    std::vector<int> counts(worldSize), displacements(worldSize);
+    MPI_Allgather(&bytes, 1, MPI_INT, counts.data(), 1, MPI_INT, MPI_COMM_WORLD);
+    int total = 0;
+    for (int r = 0; r < worldSize; r++) {
+        displacements[r] = total;
+        total += counts[r];
+    }
+    std::vector<SplitterKey> all(total / sizeof(SplitterKey));
+    MPI_Allgatherv(local.data(), bytes, MPI_BYTE, all.data(), counts.data(), displacements.data(), MPI_BYTE,
+                   MPI_COMM_WORLD);
+    std::sort(all.begin(), all.end());
+
+    std::vector<SplitterKey> splitters;
+    for (int k = 1; k < worldSize && !all.empty(); k++) splitters.push_back(all[all.size() * k / worldSize]);
+    return splitters;
+}
+
+// bounds[r] is where the bucket for rank r starts in the sorted slice, and
+// bounds[worldSize] is n: values below splitter k go to ranks 0 .. k
+std::vector<long long> bucketBounds(const int* sorted, long long n, const std::vector<SplitterKey>& splitters) {
+    std::vector<long long> bounds(worldSize + 1, n);
+    bounds[0] = 0;
+    for (size_t k = 0; k < splitters.size(); k++) {
+        const SplitterKey& splitter = splitters[k];
+        long long lo = std::lower_bound(sorted, sorted + n, splitter.value) - sorted;
+        long long hi = std::upper_bound(sorted + lo, sorted + n, splitter.value) - sorted;
+        bounds[k + 1] = worldRank < splitter.rank ? hi
+                      : worldRank > splitter.rank ? lo
+                      : std::clamp(splitter.index, lo, hi);
+    }
+    return bounds;
+}
+
+// Merges the sorted runs of src into dst[0, n), each thread producing its own
+// slice of dst
+void parallelMergeRuns(const int* src, const std::vector<SortedRun>& runs, long long n, int* dst) {
+    #pragma omp parallel
+    {
+        const long long p = ompNumThreads();
+        const long long t = ompThreadNum();
+        std::vector<long long> from, to;
+        selectMultiwaySplit(src, runs, n * t / p, from);
+        selectMultiwaySplit(src, runs, n * (t + 1) / p, to);
+        mergeRuns(src, from, to, dst + n * t / p);
+    }
+}
+
+// Writes values[0, n), elements offset .. offset + n - 1 of a sorted dataset
+// of total values, into a binary file shared by all ranks
+void writeBinarySlice(const char* filename, const int* values, long long n, long long offset, long long total,
+                      uint64_t checksum) {
+    MPI_File file = openFile(filename, MPI_MODE_CREATE | MPI_MODE_WRONLY);
+    MPI_File_set_size(file, sizeof(BinaryHeader) + total * sizeof(int));
+    if (worldRank == 0) {
+        BinaryHeader header = makeBinaryHeader(static_cast<uint64_t>(total), checksum, true);
+        writeAt(file, 0, reinterpret_cast<const char*>(&header), sizeof(header), filename);
+    }
+    writeAt(file, sizeof(BinaryHeader) + offset * sizeof(int), reinterpret_cast<const char*>(values),
+            n * static_cast<long long>(sizeof(int)), filename);
+    MPI_File_close(&file);
+}
+
+// Same for a CSV file: the byte offset of the slice is the prefix sum of the
+// formatted lengths of the ranks before it, and within the slice every thread
+// formats its own part as in writeCsvParallel
+void writeCsvSlice(const char* filename, const int* values, long long n, long long offset, long long total) {
+    const bool holdsLast = n > 0 && offset + n == total;  // no separator after the last value
+    const int numSlices = mpiThreadsSerialized ? static_cast<int>(std::max(1LL, std::min<long long>(ompMaxThreads(), n))) : 1;
+
+    std::vector<long long> sliceOffsets(numSlices + 1, 0);
+    #pragma omp parallel for schedule(static, 1)
+    for (int s = 0; s < numSlices; s++) {
+        long long bytes = 0;
+        for (long long i = n * s / numSlices; i < n * (s + 1) / numSlices; i++) bytes += formattedLength(values[i]) + 1;
+        sliceOffsets[s + 1] = bytes;
+    }
+    for (int s = 0; s < numSlices; s++) sliceOffsets[s + 1] += sliceOffsets[s];
+    long long localBytes = sliceOffsets[numSlices] - (holdsLast ? 1 : 0);
+
+    long long byteOffset = 0, totalBytes = 0;
+    MPI_Exscan(&localBytes, &byteOffset, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+    if (worldRank == 0) byteOffset = 0;
+    MPI_Allreduce(&localBytes, &totalBytes, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+
+    MPI_File file = openFile(filename, MPI_MODE_CREATE | MPI_MODE_WRONLY);
+    MPI_File_set_size(file, totalBytes);
+
+    // With a single slice the loop runs on the master thread, which is all
+    // MPI_THREAD_FUNNELED allows
+    #pragma omp parallel for schedule(static, 1)
+    for (int s = 0; s < numSlices; s++) {
+        std::vector<char> buffer(CSV_WRITE_BUFFER_SIZE);
+        char* const bufferEnd = buffer.data() + buffer.size() - 16;
+        char* out = buffer.data();
+        MPI_Offset position = byteOffset + sliceOffsets[s];
+
+        auto flush = [&] {
+            #pragma omp critical(mpi_io)
+            writeAt(file, position, buffer.data(), out - buffer.data(), filename);
+            position += out - buffer.data();
+            out = buffer.data();
+        };
+        for (long long i = n * s / numSlices; i < n * (s + 1) / numSlices; i++) {
+            out = std::to_chars(out, bufferEnd, values[i]).ptr;
+            if (!(holdsLast && i == n - 1)) *out++ = ',';
+            if (out >= bufferEnd - 16) flush();
+        }
+        flush();
+    }
+    MPI_File_close(&file);
+}
+
+// Largest value of the phase times across ranks, where the slowest rank
+// decides
+double maxOverRanks(double seconds) {
+    double slowest = 0;
+    MPI_Reduce(&seconds, &slowest, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    return slowest;
+}
+
+int main(int argc, char* argv[]) {
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_SERIALIZED, &provided);
+    mpiThreadsSerialized = provided >= MPI_THREAD_SERIALIZED;
+    MPI_Comm_rank(MPI_COMM_WORLD, &worldRank);
+    MPI_Comm_size(MPI_COMM_WORLD, &worldSize);
+
+    // --binary switches both files to the raw binary format (see binary_io.h),
+    // --generate N generates N values in [1, --max-value] instead of reading,
+    // --seed S fixes the seed of --generate,
+    // --no-output skips writing the sorted file, --no-verify its verification,
+    // --tabular prints one DISTRIBUTED line instead of the report
+    bool binaryFormat = false;
+    long long generateCount = -1;
+    int maxValue = 1000;
+    uint64_t seed = static_cast<uint64_t>(time(nullptr));
+    bool writeOutput = true;
+    bool verify = true;
+    bool tabular = false;
+    for (int a = 1; a < argc; a++) {
+        if (std::strcmp(argv[a], "--binary") == 0) binaryFormat = true;
+        else if (std::strcmp(argv[a], "--generate") == 0 && a + 1 < argc) generateCount = std::max(0LL, std::atoll(argv[++a]));
+        else if (std::strcmp(argv[a], "--max-value") == 0 && a + 1 < argc) maxValue = std::max(1, std::atoi(argv[++a]));
+        else if (std::strcmp(argv[a], "--seed") == 0 && a + 1 < argc) seed = std::strtoull(argv[++a], nullptr, 10);
+        else if (std::strcmp(argv[a], "--no-output") == 0) writeOutput = false;
+        else if (std::strcmp(argv[a], "--no-verify") == 0) verify = false;
+        else if (std::strcmp(argv[a], "--tabular") == 0) tabular = true;
+    }
+    const char* inputFile = binaryFormat ? BINARY_INPUT_FILE : INPUT_FILE;
+    const char* outputFile = binaryFormat ? BINARY_OUTPUT_FILE : OUTPUT_FILE;
+    MPI_Bcast(&seed, 1, MPI_UINT64_T, 0, MPI_COMM_WORLD);  // every rank draws from the same stream
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    const double start = MPI_Wtime();
+
+    // 1. This rank's share of the input, and its checksum
+    long long count;
+    uint64_t checksum = 0;
+    std::unique_ptr<NumaBuffer<int>> local;
+    if (generateCount >= 0) {
+        long long first = generateCount * worldRank / worldSize;
+        count = generateCount * (worldRank + 1) / worldSize - first;
+        if (count > INT_MAX) abortOnError("generating more than INT_MAX values per rank; use more ranks");
+        local = std::make_unique<NumaBuffer<int>>(count);
+        fillRandomParallel(local->data(), static_cast<int>(count), 1, maxValue, seed, first, &checksum);
+    } else {
+        local = binaryFormat ? readBinarySlice(inputFile, count) : readCsvSlice(inputFile, count);
+        checksum = binaryChecksum(local->data(), count);
+    }
+    if (count > INT_MAX) abortOnError("reading more than INT_MAX values per rank; use more ranks");
+    const double readTime = MPI_Wtime() - start;
+
+    long long inputCount = 0;
+    uint64_t inputChecksum = 0;
+    MPI_Allreduce(&count, &inputCount, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+    MPI_Allreduce(&checksum, &inputChecksum, 1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    const double sortStart = MPI_Wtime();
+
+    // 2. Local sort
+    parallelRadixSort(local->data(), count);
+    const double localSortEnd = MPI_Wtime();
+
+    // 3. Splitters, and the bucket of every destination rank
+    std::vector<SplitterKey> splitters = selectGlobalSplitters(local->data(), count);
+    std::vector<long long> bounds = bucketBounds(local->data(), count, splitters);
+    const double splitterEnd = MPI_Wtime();
+
+    // 4. Bucket exchange and merge of the received runs
+    std::vector<int> sendCounts(worldSize), sendDisplacements(worldSize);
+    std::vector<int> receiveCounts(worldSize), receiveDisplacements(worldSize);
+    for (int r = 0; r < worldSize; r++) {
+        sendCounts[r] = static_cast<int>(bounds[r + 1] - bounds[r]);
+        sendDisplacements[r] = static_cast<int>(bounds[r]);
+    }
+    MPI_Alltoall(sendCounts.data(), 1, MPI_INT, receiveCounts.data(), 1, MPI_INT, MPI_COMM_WORLD);
+    long long received = 0;
+    std::vector<SortedRun> runs;
+    for (int r = 0; r < worldSize; r++) {
+        runs.push_back({received, received + receiveCounts[r]});
+        received += receiveCounts[r];
+    }
+    if (received > INT_MAX) abortOnError("receiving more than INT_MAX values on one rank; use more ranks");
+    for (int r = 0; r < worldSize; r++) receiveDisplacements[r] = static_cast<int>(runs[r].begin);
+
+    auto incoming = std::make_unique<NumaBuffer<int>>(received);
+    MPI_Alltoallv(local->data(), sendCounts.data(), sendDisplacements.data(), MPI_INT, incoming->data(),
+                  receiveCounts.data(), receiveDisplacements.data(), MPI_INT, MPI_COMM_WORLD);
+    local.reset();
+    const double exchangeEnd = MPI_Wtime();
+
+    NumaBuffer<int> sorted(received);
+    parallelMergeRuns(incoming->data(), runs, received, sorted.data());
+    incoming.reset();
+    const double mergeEnd = MPI_Wtime();
+
+    // This rank's slice is elements offset .. offset + received - 1 of the output
+    long long offset = 0;
+    MPI_Exscan(&received, &offset, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+    if (worldRank == 0) offset = 0;
+    MPI_Barrier(MPI_COMM_WORLD);
+    const double sortEnd = MPI_Wtime();
+
+    // 5. Output; the input checksum stands in for the output's, as in the
+    //    sorted files of parallel_random_number_sorter
+    if (writeOutput) {
+        if (binaryFormat) writeBinarySlice(outputFile, sorted.data(), received, offset, inputCount, inputChecksum);
+        else writeCsvSlice(outputFile, sorted.data(), received, offset, inputCount);
+    }
+    const double writeTime = MPI_Wtime() - sortEnd;
+    MPI_Barrier(MPI_COMM_WORLD);
+    const double totalTime = MPI_Wtime() - start;
+
+    double phases[] = {
+        maxOverRanks(readTime), maxOverRanks(localSortEnd - sortStart), maxOverRanks(splitterEnd - localSortEnd),
+        maxOverRanks(exchangeEnd - splitterEnd), maxOverRanks(mergeEnd - exchangeEnd), maxOverRanks(writeTime)
+    };
+    long long largestBucket = 0;
+    MPI_Reduce(&received, &largestBucket, 1, MPI_LONG_LONG, MPI_MAX, 0, MPI_COMM_WORLD);
+    const double sortTime = sortEnd - sortStart;
+
+    if (worldRank == 0 && tabular) {
+        std::cout << "DISTRIBUTED\t" << worldSize << "\t" << ompMaxThreads() << "\t" << inputCount << "\t"
+                  << sortTime << "\t" << totalTime << std::endl;
+    } else if (worldRank == 0) {
+        const char* phaseNames[] = {generateCount >= 0 ? "Generate" : "Read", "Local sort", "Splitter selection",
+                                    "Exchange", "Merge", "Write"};
+        std::cout << "Ranks: " << worldSize << ", threads per rank: " << ompMaxThreads() << std::endl;
+        std::cout << "Values: " << inputCount << std::endl;
+        for (int p = 0; p < 6; p++) std::cout << phaseNames[p] << " time: " << phases[p] << " seconds" << std::endl;
+        std::cout << "Sort time: " << sortTime << " seconds" << std::endl;
+        std::cout << "Time taken: " << totalTime << " seconds" << std::endl;
+        std::cout << "Bucket imbalance: "
+                  << (inputCount > 0 ? static_cast<double>(largestBucket) * worldSize / inputCount : 1.0) << std::endl;
+        if (generateCount >= 0) std::cout << "Seed: " << seed << std::endl;
+        else std::cout << "Input file: " << inputFile << std::endl;
+        if (writeOutput) std::cout << "Output file: " << outputFile << std::endl;
+    }
+
+    // 6. Verification: order within each slice and across slice boundaries,
+    //    then count and checksum against the input
+    bool verified = true;
+    if (verify) {
+        SortVerifier verifier = verifySorted(sorted.data(), received);
+        int last = received > 0 ? sorted[received - 1] : INT_MIN;
+        int lastBefore = INT_MIN;
+        MPI_Exscan(&last, &lastBefore, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+        if (worldRank == 0) lastBefore = INT_MIN;
+
+        long long firstUnsorted = verifier.sorted() ? LLONG_MAX : offset + verifier.firstUnsorted();
+        if (received > 0 && lastBefore > sorted[0]) firstUnsorted = std::min(firstUnsorted, offset);
+        long long globalFirstUnsorted, outputCount;
+        uint64_t localChecksum = verifier.checksum(), outputChecksum;
+        MPI_Allreduce(&firstUnsorted, &globalFirstUnsorted, 1, MPI_LONG_LONG, MPI_MIN, MPI_COMM_WORLD);
+        MPI_Allreduce(&received, &outputCount, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+        MPI_Allreduce(&localChecksum, &outputChecksum, 1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+
+        verified = globalFirstUnsorted == LLONG_MAX && outputCount == inputCount && outputChecksum == inputChecksum;
+        if (worldRank == 0 && (!tabular || !verified)) {
+            reportVerification(globalFirstUnsorted == LLONG_MAX ? -1 : globalFirstUnsorted, outputCount,
+                               outputChecksum, inputCount, &inputChecksum);
+        }
+    }
+
+    MPI_Finalize();
+    return verified ? 0 : 1;
+}
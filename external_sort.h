@@ -0,0 +1,511 @@
+/*
+ * File: external_sort.h
+ *
+ * Description:
+ * External-memory sort for datasets larger than RAM, in either the CSV or
+ * the binary format (see binary_io.h), bounded by a memory budget:
+ * 1. Run formation: the input is read sequentially in runs of at most half
+ *    the budget, each run is sorted in memory with the caller's engine and
+ *    spilled to an unlinked temp file. Two run buffers alternate, so the
+ *    spill of one run overlaps reading and sorting the next.
+ * 2. Merging: the runs are merged with a loser tree (one comparison per tree
+ *    level per output value). Every run is read through two blocks, so the
+ *    next block is fetched in the background while the current one is
+ *    consumed, and the output is written the same way. If there are more runs
+ *    than the budget can give blocks to, groups of runs are first merged into
+ *    longer runs.
+ *
+ * Every buffer is charged to the budget: the CSV reader's stream buffer during
+ * run formation, and in the final merge the formatted text of the CSV output
+ * blocks (CSV_TEXT_BYTES_PER_VALUE per value) next to their values.
+ *
+ * The output is written in the input's format. Temp files go to $TMPDIR
+ * (default /tmp) and disappear when they are closed.
+ */
+
+#ifndef EXTERNAL_SORT_H
+#define EXTERNAL_SORT_H
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <memory>
+#include <future>
+#include <algorithm>
+#include <charconv>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "csv_io.h"
+#include "binary_io.h"
+
+const size_t EXTERNAL_SORT_DEFAULT_BUDGET = static_cast<size_t>(256) << 20;
+const long long EXTERNAL_MIN_RUN_VALUES = 1 << 16;
+const long long EXTERNAL_MIN_BLOCK_VALUES = 1 << 14;
+const size_t CSV_STREAM_BUFFER_SIZE = 1 << 20;
+const size_t CSV_TEXT_BYTES_PER_VALUE = 12;  // ',' and up to 11 characters
+
+// Reads all of length bytes at file offset, retrying on short reads
+inline void preadAll(int fd, char* buffer, size_t length, off_t offset, const char* filename) {
+    while (length > 0) {
+        ssize_t got = pread(fd, buffer, length, offset);
+        if (got <= 0) {
+            std::cerr << "Error reading file: " << filename << std::endl;
+            exit(1);
+        }
+        buffer += got;
+        length -= static_cast<size_t>(got);
+        offset += got;
+    }
+}
+
+// Sequential reader of a CSV or binary dataset that hands out the values in
+// pieces of a caller-chosen size, so the file never has to fit in memory
+class DatasetReader {
+public:
+    explicit DatasetReader(const char* filename) : filename_(filename), binary_(isBinaryFile(filename)) {
+        fd_ = open(filename, O_RDONLY);
+        if (fd_ < 0) {
+            std::cerr << "Error opening file: " << filename << std::endl;
+            exit(1);
+        }
+
+        if (binary_) {
+            struct stat st;
+            BinaryHeader header;
+            if (fstat(fd_, &st) != 0 || pread(fd_, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) ||
+                !isValidBinaryHeader(header, static_cast<size_t>(st.st_size))) {
+                std::cerr << "Error: corrupt binary dataset: " << filename << std::endl;
+                exit(1);
+            }
+            remaining_ = static_cast<long long>(header.count);
+            offset_ = sizeof(BinaryHeader);
+        } else {
+            buffer_.resize(CSV_STREAM_BUFFER_SIZE);
+        }
+    }
+
+    ~DatasetReader() {
+        close(fd_);
+    }
+
+    DatasetReader(const DatasetReader&) = delete;
+    DatasetReader& operator=(const DatasetReader&) = delete;
+
+    bool binary() const { return binary_; }
+
+    // Reads up to capacity values into out; returns 0 once the file is exhausted
+    long long read(int* out, long long capacity) {
+        if (binary_) {
+            long long n = std::min(capacity, remaining_);
+            preadAll(fd_, reinterpret_cast<char*>(out), static_cast<size_t>(n) * sizeof(int), offset_, filename_);
+            offset_ += static_cast<off_t>(n) * sizeof(int);
+            remaining_ -= n;
+            return n;
+        }
+
+        long long total = 0;
+        while (total < capacity) {
+            // Without the end of file in the buffer, a trailing value may be
+            // cut off, so only parse up to the last separator
+            size_t limit = end_;
+            if (!eof_) {
+                while (limit > begin_ && (isCsvDigit(buffer_[limit - 1]) || buffer_[limit - 1] == '-')) limit--;
+            }
+
+            const char* stop = buffer_.data() + begin_;
+            total += parseCsvValues(buffer_.data() + begin_, buffer_.data() + limit, out + total, capacity - total, &stop);
+            begin_ = static_cast<size_t>(stop - buffer_.data());
+            if (total == capacity) break;
+            if (eof_) break;
+            refill();
+        }
+        return total;
+    }
+
+private:
+    // Moves the unparsed tail to the front and appends the next bytes
+    void refill() {
+        size_t tail = end_ - begin_;
+        std::memmove(buffer_.data(), buffer_.data() + begin_, tail);
+        begin_ = 0;
+        end_ = tail;
+        ssize_t got = ::read(fd_, buffer_.data() + end_, buffer_.size() - end_);
+        if (got < 0) {
+            std::cerr << "Error reading file: " << filename_ << std::endl;
+            exit(1);
+        }
+        if (got == 0) eof_ = true;
+        end_ += static_cast<size_t>(got);
+    }
+
+    const char* filename_;
+    bool binary_;
+    int fd_;
+    long long remaining_ = 0;
+    off_t offset_ = 0;
+    std::vector<char> buffer_;
+    size_t begin_ = 0;
+    size_t end_ = 0;
+    bool eof_ = false;
+};
+
+// Temp file holding one sorted run as raw ints. It is unlinked right after
+// creation, so it is removed when closed even if the process dies.
+class SpillFile {
+public:
+    SpillFile() {
+        const char* dir = std::getenv("TMPDIR");
+        std::string path = std::string(dir != nullptr && *dir != '\0' ? dir : "/tmp") + "/s2p_run_XXXXXX";
+        fd_ = mkstemp(path.data());
+        if (fd_ < 0) {
+            std::cerr << "Error opening file: " << path << std::endl;
+            exit(1);
+        }
+        unlink(path.c_str());
+    }
+
+    ~SpillFile() {
+        close(fd_);
+    }
+
+    SpillFile(const SpillFile&) = delete;
+    SpillFile& operator=(const SpillFile&) = delete;
+
+    int fd() const { return fd_; }
+    long long size() const { return size_; }
+    void setSize(long long size) { size_ = size; }
+
+private:
+    int fd_;
+    long long size_ = 0;
+};
+
+// Sequential writer with two blocks of values: while one block is being
+// written in the background, the caller fills the other. Values are written
+// as raw ints, or as a comma-separated line when csv is set.
+class BlockWriter {
+public:
+    BlockWriter(int fd, off_t offset, bool csv, long long blockValues, const char* filename)
+        : fd_(fd), offset_(offset), csv_(csv), capacity_(blockValues), filename_(filename) {
+        for (int slot = 0; slot < 2; slot++) {
+            values_[slot].resize(blockValues);
+            if (csv_) text_[slot].resize(static_cast<size_t>(blockValues) * CSV_TEXT_BYTES_PER_VALUE);
+        }
+    }
+
+    ~BlockWriter() {
+        finish();
+    }
+
+    BlockWriter(const BlockWriter&) = delete;
+    BlockWriter& operator=(const BlockWriter&) = delete;
+
+    int* block() { return values_[current_].data(); }
+    long long capacity() const { return capacity_; }
+    long long written() const { return written_; }
+
+    // Starts writing the first n values of block() and switches to the other block
+    void flush(long long n) {
+        if (n <= 0) return;
+        int slot = current_;
+        const char* bytes = reinterpret_cast<const char*>(values_[slot].data());
+        size_t length = static_cast<size_t>(n) * sizeof(int);
+        if (csv_) {
+            char* out = text_[slot].data();
+            for (long long i = 0; i < n; i++) {
+                if (written_ + i > 0) *out++ = ',';
+                out = std::to_chars(out, out + CSV_TEXT_BYTES_PER_VALUE - 1, values_[slot][i]).ptr;
+            }
+            bytes = text_[slot].data();
+            length = static_cast<size_t>(out - text_[slot].data());
+        }
+
+        pending_[slot] = std::async(std::launch::async, [this, bytes, length, offset = offset_] {
+            pwriteAll(fd_, bytes, length, offset, filename_);
+        });
+        offset_ += static_cast<off_t>(length);
+        written_ += n;
+        current_ ^= 1;
+        if (pending_[current_].valid()) pending_[current_].get();
+    }
+
+    // Waits until everything flushed so far is on its way to the file
+    void finish() {
+        for (std::future<void>& pending : pending_) {
+            if (pending.valid()) pending.get();
+        }
+    }
+
+private:
+    int fd_;
+    off_t offset_;
+    bool csv_;
+    long long capacity_;
+    const char* filename_;
+    std::vector<int> values_[2];
+    std::vector<char> text_[2];
+    std::future<void> pending_[2];
+    int current_ = 0;
+    long long written_ = 0;
+};
+
+// Memory of a BlockWriter in ints per value of its block size: two blocks of
+// values, plus their text in CSV mode
+inline long long blockWriterFootprint(bool csv) {
+    return 2 * (1 + (csv ? static_cast<long long>(CSV_TEXT_BYTES_PER_VALUE / sizeof(int)) : 0));
+}
+
+// Block size of a merge of fanIn runs (two blocks each) into a BlockWriter,
+// within budgetValues ints
+inline long long mergeBlockValues(long long budgetValues, long long fanIn, bool csvOutput) {
+    return std::max(EXTERNAL_MIN_BLOCK_VALUES, budgetValues / (2 * fanIn + blockWriterFootprint(csvOutput)));
+}
+
+// Reads a spilled run through two blocks; the next block is fetched in the
+// background while the current one is consumed
+class RunStream {
+public:
+    RunStream(const SpillFile& file, long long blockValues)
+        : fd_(file.fd()), total_(file.size()), blockValues_(blockValues), front_(blockValues), back_(blockValues) {
+        prefetch();
+        refill();
+    }
+
+    bool done() const { return pos_ == length_; }
+    int head() const { return front_[pos_]; }
+
+    void advance() {
+        if (++pos_ == length_) refill();
+    }
+
+private:
+    void prefetch() {
+        pendingLength_ = std::min(blockValues_, total_ - next_);
+        if (pendingLength_ == 0) return;
+        char* target = reinterpret_cast<char*>(back_.data());
+        size_t bytes = static_cast<size_t>(pendingLength_) * sizeof(int);
+        off_t offset = static_cast<off_t>(next_) * sizeof(int);
+        pending_ = std::async(std::launch::async, [this, target, bytes, offset] {
+            preadAll(fd_, target, bytes, offset, "spill file");
+        });
+        next_ += pendingLength_;
+    }
+
+    void refill() {
+        pos_ = 0;
+        length_ = pendingLength_;
+        if (length_ == 0) return;
+        pending_.get();
+        front_.swap(back_);
+        prefetch();
+    }
+
+    int fd_;
+    long long total_;
+    long long blockValues_;
+    long long next_ = 0;
+    std::vector<int> front_;
+    std::vector<int> back_;
+    long long pos_ = 0;
+    long long length_ = 0;
+    long long pendingLength_ = 0;
+    std::future<void> pending_;
+};
+
+// Sorted run that is already in memory, with the same interface as RunStream
+class MemoryRun {
+public:
+    MemoryRun(const int* begin, const int* end) : pos_(begin), end_(end) {}
+
+    bool done() const { return pos_ == end_; }
+    int head() const { return *pos_; }
+    void advance() { ++pos_; }
+
+private:
+    const int* pos_;
+    const int* end_;
+};
+
+// Tournament tree of losers over the heads of k runs: tree_[0] is the run with
+// the smallest head and tree_[1 .. k - 1] hold the losers of the internal
+// matches, so replacing the winner's head replays a single leaf-to-root path.
+// Exhausted runs lose every match. Run is RunStream or MemoryRun.
+template <typename Run>
+class LoserTree {
+public:
+    explicit LoserTree(std::vector<std::unique_ptr<Run>>& runs) : runs_(runs), k_(static_cast<int>(runs.size())), tree_(k_ > 0 ? k_ : 1, -1) {
+        for (int leaf = 0; leaf < k_; leaf++) insert(leaf);
+    }
+
+    int winner() const { return tree_[0]; }
+
+    // Restores the tree after the winner's head has changed
+    void replay(int leaf) {
+        int winner = leaf;
+        for (int node = (leaf + k_) / 2; node > 0; node /= 2) {
+            if (beats(tree_[node], winner)) std::swap(tree_[node], winner);
+        }
+        tree_[0] = winner;
+    }
+
+private:
+    bool beats(int a, int b) const {
+        if (runs_[a]->done()) return false;
+        if (runs_[b]->done()) return true;
+        return runs_[a]->head() < runs_[b]->head();
+    }
+
+    // Initial play: a leaf climbs until it meets an empty node, where it
+    // waits for the winner of the sibling subtree
+    void insert(int leaf) {
+        int winner = leaf;
+        for (int node = (leaf + k_) / 2; node > 0; node /= 2) {
+            if (tree_[node] == -1) {
+                tree_[node] = winner;
+                return;
+            }
+            if (beats(tree_[node], winner)) std::swap(tree_[node], winner);
+        }
+        tree_[0] = winner;
+    }
+
+    std::vector<std::unique_ptr<Run>>& runs_;
+    int k_;
+    std::vector<int> tree_;
+};
+
+// Merges runs into writer through a loser tree
+template <typename Run>
+void mergeIntoWriter(std::vector<std::unique_ptr<Run>>& runs, BlockWriter& writer) {
+    if (runs.empty()) return;
+
+    LoserTree<Run> tree(runs);
+    int* out = writer.block();
+    long long n = 0;
+    while (true) {
+        int w = tree.winner();
+        if (runs[w]->done()) break;
+        out[n++] = runs[w]->head();
+        runs[w]->advance();
+        tree.replay(w);
+        if (n == writer.capacity()) {
+            writer.flush(n);
+            out = writer.block();
+            n = 0;
+        }
+    }
+    writer.flush(n);
+    writer.finish();
+}
+
+// Merges the given spilled runs into writer
+inline void mergeSpilledRuns(const std::vector<SpillFile*>& inputs, long long blockValues, BlockWriter& writer) {
+    std::vector<std::unique_ptr<RunStream>> runs;
+    for (SpillFile* input : inputs) runs.emplace_back(new RunStream(*input, blockValues));
+    mergeIntoWriter(runs, writer);
+}
+
+// Creates outputFile for a sorted dataset of count values; for the binary
+// format the header is written first. Returns the descriptor and sets
+// payloadOffset to where the values start.
+inline int openSortedOutput(const char* outputFile, bool binary, long long count, uint64_t checksum, off_t& payloadOffset) {
+    int fd = open(outputFile, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "Error opening file: " << outputFile << std::endl;
+        exit(1);
+    }
+    payloadOffset = 0;
+    if (binary) {
+        BinaryHeader header = makeBinaryHeader(static_cast<uint64_t>(count), checksum, true);
+        pwriteAll(fd, reinterpret_cast<const char*>(&header), sizeof(header), 0, outputFile);
+        payloadOffset = sizeof(header);
+    }
+    return fd;
+}
+
+struct ExternalSortStats {
+    long long values = 0;
+    int runs = 0;
+    int mergePasses = 0;
+};
+
+// Sorts inputFile into outputFile within about memoryBudget bytes. sortRun(run, n)
+// sorts one in-memory run of n values.
+template <typename SortRun>
+ExternalSortStats externalSort(const char* inputFile, const char* outputFile, size_t memoryBudget, SortRun sortRun) {
+    const long long budgetValues = static_cast<long long>(memoryBudget / sizeof(int));
+    const bool binary = isBinaryFile(inputFile);
+    ExternalSortStats stats;
+
+    // Run formation, spilling one run while the next is read and sorted; the
+    // two run buffers share the budget with the CSV reader's stream buffer
+    std::vector<std::unique_ptr<SpillFile>> spills;
+    uint64_t checksum = 0;
+    {
+        DatasetReader reader(inputFile);
+        const long long readerValues = binary ? 0 : static_cast<long long>(CSV_STREAM_BUFFER_SIZE / sizeof(int));
+        const long long runCapacity = std::min<long long>(std::max((budgetValues - readerValues) / 2, EXTERNAL_MIN_RUN_VALUES), INT_MAX);
+        std::vector<int> buffers[2] = {std::vector<int>(runCapacity), std::vector<int>(runCapacity)};
+        std::future<void> spilling[2];
+        for (int slot = 0;; slot ^= 1) {
+            if (spilling[slot].valid()) spilling[slot].get();
+            long long n = reader.read(buffers[slot].data(), runCapacity);
+            if (n == 0) break;
+
+            checksum += binaryChecksum(buffers[slot].data(), n);
+            sortRun(buffers[slot].data(), n);
+            spills.emplace_back(new SpillFile());
+            SpillFile* spill = spills.back().get();
+            spill->setSize(n);
+            const char* bytes = reinterpret_cast<const char*>(buffers[slot].data());
+            spilling[slot] = std::async(std::launch::async, [spill, bytes, n] {
+                pwriteAll(spill->fd(), bytes, static_cast<size_t>(n) * sizeof(int), 0, "spill file");
+            });
+            stats.values += n;
+        }
+        for (std::future<void>& pending : spilling) {
+            if (pending.valid()) pending.get();
+        }
+    }
+    stats.runs = static_cast<int>(spills.size());
+
+    // Two blocks per input run and the output writer, which in the final CSV
+    // merge also holds the text, must fit the budget
+    const long long maxFanIn = std::max<long long>(2, (budgetValues / EXTERNAL_MIN_BLOCK_VALUES - blockWriterFootprint(!binary)) / 2);
+    while (static_cast<long long>(spills.size()) > maxFanIn) {
+        std::vector<std::unique_ptr<SpillFile>> merged;
+        for (size_t first = 0; first < spills.size(); first += maxFanIn) {
+            size_t last = std::min(spills.size(), first + static_cast<size_t>(maxFanIn));
+            std::vector<SpillFile*> group;
+            for (size_t s = first; s < last; s++) group.push_back(spills[s].get());
+
+            merged.emplace_back(new SpillFile());
+            long long blockValues = mergeBlockValues(budgetValues, static_cast<long long>(group.size()), false);
+            BlockWriter writer(merged.back()->fd(), 0, false, blockValues, "spill file");
+            mergeSpilledRuns(group, blockValues, writer);
+            merged.back()->setSize(writer.written());
+        }
+        spills.swap(merged);
+        stats.mergePasses++;
+    }
+
+    // Final merge straight into the output file
+    off_t payloadOffset;
+    int fd = openSortedOutput(outputFile, binary, stats.values, checksum, payloadOffset);
+    std::vector<SpillFile*> inputs;
+    for (std::unique_ptr<SpillFile>& spill : spills) inputs.push_back(spill.get());
+    long long blockValues = mergeBlockValues(budgetValues, static_cast<long long>(inputs.size()), !binary);
+    {
+        BlockWriter writer(fd, payloadOffset, !binary, blockValues, outputFile);
+        mergeSpilledRuns(inputs, blockValues, writer);
+    }
+    stats.mergePasses++;
+    close(fd);
+    return stats;
+}
+
+#endif // EXTERNAL_SORT_H
@@ -0,0 +1,177 @@
+/*
+ * File: input_distributions.h
+ *
+ * Description:
+ * Benchmark input generators beyond uniform random keys. Production inputs
+ * are often presorted, skewed or full of duplicates, which is where pivot
+ * choice, duplicate handling and bucket balance matter most:
+ * - uniform:       random keys in [1, DISTRIBUTION_MAX_VALUE]
+ * - sorted:        a non-decreasing ramp over the same range
+ * - reverse:       the ramp in descending order
+ * - nearly-sorted: the ramp with round(N * NEARLY_SORTED_SWAP_FRACTION)
+ *                  random pairs of positions swapped
+ * - few-unique:    FEW_UNIQUE_VALUES distinct keys in random order
+ * - zipf:          ranks 1 .. ZIPF_UNIQUE_VALUES drawn with probability
+ *                  proportional to 1 / rank
+ * - sawtooth:      SAWTOOTH_TEETH ascending ramps one after the other
+ * - organ-pipe:    an ascending ramp followed by a descending one
+ * - all-equal:     the same key everywhere
+ * Random draws come from the Philox stream of random_engine.h, so an input is
+ * a pure function of (distribution, N, seed) at any thread count.
+ */
+
+#ifndef INPUT_DISTRIBUTIONS_H
+#define INPUT_DISTRIBUTIONS_H
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include "random_engine.h"
+
+const int DISTRIBUTION_MAX_VALUE = 1000000;
+const double NEARLY_SORTED_SWAP_FRACTION = 0.01;
+const int FEW_UNIQUE_VALUES = 16;
+const int ZIPF_UNIQUE_VALUES = 1 << 16;
+const int SAWTOOTH_TEETH = 16;
+
+enum class InputDistribution {
+    Uniform,
+    Sorted,
+    Reverse,
+    NearlySorted,
+    FewUnique,
+    Zipf,
+    Sawtooth,
+    OrganPipe,
+    AllEqual
+};
+
+const InputDistribution ALL_INPUT_DISTRIBUTIONS[] = {
+    InputDistribution::Uniform, InputDistribution::Sorted, InputDistribution::Reverse,
+    InputDistribution::NearlySorted, InputDistribution::FewUnique, InputDistribution::Zipf,
+    InputDistribution::Sawtooth, InputDistribution::OrganPipe, InputDistribution::AllEqual
+};
+
+inline const char* distributionName(InputDistribution distribution) {
+    switch (distribution) {
+        case InputDistribution::Sorted: return "sorted";
+        case InputDistribution::Reverse: return "reverse";
+        case InputDistribution::NearlySorted: return "nearly-sorted";
+        case InputDistribution::FewUnique: return "few-unique";
+        case InputDistribution::Zipf: return "zipf";
+        case InputDistribution::Sawtooth: return "sawtooth";
+        case InputDistribution::OrganPipe: return "organ-pipe";
+        case InputDistribution::AllEqual: return "all-equal";
+        default: return "uniform";
+    }
+}
+
+// Column prefix in the CSV report, such as "Nearly-Sorted"
+inline std::string distributionLabel(InputDistribution distribution) {
+    std::string label = distributionName(distribution);
+    for (size_t i = 0; i < label.size(); i++) {
+        if (i == 0 || label[i - 1] == '-') label[i] = static_cast<char>(label[i] - 'a' + 'A');
+    }
+    return label;
+}
+
+// Returns false for an unknown name
+inline bool parseDistribution(const char* name, InputDistribution& distribution) {
+    for (InputDistribution candidate : ALL_INPUT_DISTRIBUTIONS) {
+        if (std::strcmp(name, distributionName(candidate)) == 0) {
+            distribution = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Key i of a non-decreasing ramp of N keys over [1, DISTRIBUTION_MAX_VALUE]
+inline int rampValue(long long i, long long N) {
+    return 1 + static_cast<int>(i * DISTRIBUTION_MAX_VALUE / std::max(1LL, N));
+}
+
+// Fills numbers[0, N) with distribution; seed only matters for the random ones
+inline void generateDistribution(InputDistribution distribution, int* numbers, int N, uint64_t seed) {
+    switch (distribution) {
+        case InputDistribution::Uniform:
+            fillRandomParallel(numbers, N, 1, DISTRIBUTION_MAX_VALUE, seed);
+            break;
+
+        case InputDistribution::Sorted:
+        case InputDistribution::NearlySorted:
+            #pragma omp parallel for schedule(static)
+            for (int i = 0; i < N; i++) numbers[i] = rampValue(i, N);
+            if (distribution == InputDistribution::NearlySorted && N > 1) {
+                // The swaps run in order so that later ones see earlier ones
+                const long long swaps = static_cast<long long>(N * NEARLY_SORTED_SWAP_FRACTION + 0.5);
+                for (long long s = 0; s < swaps; s++) {
+                    PhiloxBlock block = philox4x32(static_cast<uint64_t>(s), seed);
+                    std::swap(numbers[reduceToRange(block.v[0], N)], numbers[reduceToRange(block.v[1], N)]);
+                }
+            }
+            break;
+
+        case InputDistribution::Reverse:
+            #pragma omp parallel for schedule(static)
+            for (int i = 0; i < N; i++) numbers[i] = rampValue(N - 1 - i, N);
+            break;
+
+        case InputDistribution::FewUnique:
+            fillRandomParallel(numbers, N, 0, FEW_UNIQUE_VALUES - 1, seed);
+            #pragma omp parallel for schedule(static)
+            for (int i = 0; i < N; i++) numbers[i] = rampValue(numbers[i], FEW_UNIQUE_VALUES);
+            break;
+
+        case InputDistribution::Zipf: {
+            // Inverse transform sampling over the cumulative 1 / rank weights
+            std::vector<double> cdf(ZIPF_UNIQUE_VALUES);
+            double total = 0;
+            for (int r = 0; r < ZIPF_UNIQUE_VALUES; r++) {
+                total += 1.0 / (r + 1);
+                cdf[r] = total;
+            }
+            const double scale = total / 4294967296.0;  // 2^32
+            const long long blocks = (static_cast<long long>(N) + 3) / 4;
+
+            #pragma omp parallel for schedule(static)
+            for (long long b = 0; b < blocks; b++) {
+                PhiloxBlock block = philox4x32(static_cast<uint64_t>(b), seed);
+                for (int lane = 0; lane < 4 && b * 4 + lane < N; lane++) {
+                    double u = (block.v[lane] + 0.5) * scale;
+                    long long rank = std::lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin();
+                    numbers[b * 4 + lane] = 1 + static_cast<int>(std::min<long long>(rank, ZIPF_UNIQUE_VALUES - 1));
+                }
+            }
+            break;
+        }
+
+        case InputDistribution::Sawtooth: {
+            const long long tooth = std::max(1LL, (static_cast<long long>(N) + SAWTOOTH_TEETH - 1) / SAWTOOTH_TEETH);
+            #pragma omp parallel for schedule(static)
+            for (int i = 0; i < N; i++) numbers[i] = rampValue(i % tooth, tooth);
+            break;
+        }
+
+        case InputDistribution::OrganPipe: {
+            const long long half = (static_cast<long long>(N) + 1) / 2;
+            #pragma omp parallel for schedule(static)
+            for (int i = 0; i < N; i++) numbers[i] = rampValue(i < half ? i : N - 1 - i, half);
+            break;
+        }
+
+        case InputDistribution::AllEqual:
+            std::fill(numbers, numbers + N, DISTRIBUTION_MAX_VALUE / 2);
+            break;
+    }
+}
+
+inline std::vector<int> generateDistribution(InputDistribution distribution, int N, uint64_t seed) {
+    std::vector<int> numbers(N);
+    generateDistribution(distribution, numbers.data(), N, seed);
+    return numbers;
+}
+
+#endif // INPUT_DISTRIBUTIONS_H
@@ -0,0 +1,157 @@
+/*
+ * File: merge_sort.h
+ *
+ * Description:
+ * Parallel multiway mergesort. Its running time does not depend on pivot
+ * choices:
+ * 1. Every thread sorts one contiguous chunk with std::sort.
+ * 2. Every thread finds, for its own slice of the output, where that slice
+ *    starts in each sorted chunk (multisequence selection by binary search
+ *    over key values, with ties split greedily in chunk order).
+ * 3. Every thread merges its pieces of all chunks into its output slice of a
+ *    single auxiliary buffer, independently of the other threads.
+ * 4. Every thread copies its output slice back.
+ *
+ * The auxiliary buffer comes from the ScratchPool, so repeated sorts reuse it.
+ */
+
+#ifndef MERGE_SORT_H
+#define MERGE_SORT_H
+
+#include <vector>
+#include <algorithm>
+#include <climits>
+#include "omp_compat.h"
+#include "scratch_pool.h"
+
+// Below this size a single std::sort is faster than splitting the work
+const int MERGE_SORT_SEQUENTIAL_THRESHOLD = 1 << 14;
+
+// Sorted run arr[begin, end) taking part in a multiway merge
+struct SortedRun {
+    long long begin;
+    long long end;
+};
+
+// Splits the sorted runs at global output rank rank: on return, cut[s] is the
+// position in run s such that the sum of (cut[s] - runs[s].begin) is rank and
+// every element before a cut is <= every element after any cut
+inline void selectMultiwaySplit(const int* arr, const std::vector<SortedRun>& runs, long long rank, std::vector<long long>& cut) {
+    const size_t k = runs.size();
+    cut.assign(k, 0);
+
+    long long total = 0;
+    int lo = INT_MAX, hi = INT_MIN;
+    for (const SortedRun& run : runs) {
+        total += run.end - run.begin;
+        if (run.begin < run.end) {
+            lo = std::min(lo, arr[run.begin]);
+            hi = std::max(hi, arr[run.end - 1]);
+        }
+    }
+    if (rank <= 0 || total == 0) {
+        for (size_t s = 0; s < k; s++) cut[s] = runs[s].begin;
+        return;
+    }
+    if (rank >= total) {
+        for (size_t s = 0; s < k; s++) cut[s] = runs[s].end;
+        return;
+    }
+
+    // Smallest value v with more than rank elements <= v: the rank-th element
+    long long low = lo, high = hi;
+    while (low < high) {
+        long long mid = low + (high - low) / 2;
+        long long countLe = 0;
+        for (const SortedRun& run : runs) {
+            countLe += std::upper_bound(arr + run.begin, arr + run.end, static_cast<int>(mid)) - (arr + run.begin);
+        }
+        if (countLe > rank) high = mid;
+        else low = mid + 1;
+    }
+    int value = static_cast<int>(low);
+
+    // Everything below value goes left; ties fill the remainder in run order
+    long long remaining = rank;
+    std::vector<long long> upper(k);
+    for (size_t s = 0; s < k; s++) {
+        cut[s] = std::lower_bound(arr + runs[s].begin, arr + runs[s].end, value) - arr;
+        upper[s] = std::upper_bound(arr + cut[s], arr + runs[s].end, value) - arr;
+        remaining -= cut[s] - runs[s].begin;
+    }
+    for (size_t s = 0; s < k && remaining > 0; s++) {
+        long long take = std::min(remaining, upper[s] - cut[s]);
+        cut[s] += take;
+        remaining -= take;
+    }
+}
+
+// Merges the runs arr[from[s], to[s]) into out with a binary heap of run heads
+inline void mergeRuns(const int* arr, const std::vector<long long>& from, const std::vector<long long>& to, int* out) {
+    struct Head {
+        int value;
+        int run;
+    };
+    auto greater = [](const Head& a, const Head& b) {
+        return a.value > b.value || (a.value == b.value && a.run > b.run);
+    };
+
+    std::vector<long long> pos(from);
+    std::vector<Head> heap;
+    for (size_t s = 0; s < from.size(); s++) {
+        if (pos[s] < to[s]) heap.push_back({arr[pos[s]], static_cast<int>(s)});
+    }
+    std::make_heap(heap.begin(), heap.end(), greater);
+
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), greater);
+        Head& head = heap.back();
+        *out++ = head.value;
+        if (++pos[head.run] < to[head.run]) {
+            head.value = arr[pos[head.run]];
+            std::push_heap(heap.begin(), heap.end(), greater);
+        } else {
+            heap.pop_back();
+        }
+    }
+}
+
+// Sorts arr[0, N) with the multiway mergesort described above
+inline void parallelMultiwayMergeSort(int* arr, long long N) {
+    const int maxThreads = ompMaxThreads();
+    if (N < MERGE_SORT_SEQUENTIAL_THRESHOLD || maxThreads == 1) {
+        std::sort(arr, arr + N);
+        return;
+    }
+
+    ScratchBuffer buffer(N);
+    int* out = buffer.data();
+    std::vector<SortedRun> runs;
+
+    #pragma omp parallel
+    {
+        const int numThreads = ompNumThreads();
+        const int tid = ompThreadNum();
+
+        #pragma omp single
+        {
+            runs.resize(numThreads);
+            for (int t = 0; t < numThreads; t++) runs[t] = {N * t / numThreads, N * (t + 1) / numThreads};
+        }
+
+        std::sort(arr + runs[tid].begin, arr + runs[tid].end);
+        #pragma omp barrier
+
+        long long outBegin = N * tid / numThreads;
+        long long outEnd = N * (tid + 1) / numThreads;
+        std::vector<long long> from, to;
+        selectMultiwaySplit(arr, runs, outBegin, from);
+        selectMultiwaySplit(arr, runs, outEnd, to);
+        mergeRuns(arr, from, to, out + outBegin);
+        #pragma omp barrier
+
+        std::copy(out + outBegin, out + outEnd, arr + outBegin);
+    }
+}
+
+#endif // MERGE_SORT_H
@@ -0,0 +1,248 @@
+/*
+ * File: numa_buffer.h
+ *
+ * Description:
+ * NUMA-aware placement of the large key buffers. Linux puts a page on the
+ * node of the thread that first touches it, so a buffer zero-filled or read
+ * in by one thread ends up entirely on that thread's socket, and every other
+ * socket's threads pay remote bandwidth for the whole sort.
+ * - NumaBuffer: an uninitialized mmap allocation whose pages are first
+ *   touched in parallel, thread t touching elements [N * t / p, N * (t + 1) / p)
+ *   (the static partition the engines' per-thread chunks use), or
+ *   interleaved page by page across all nodes
+ * - parallelCopy: memcpy split in the same static partition, so each thread
+ *   writes the pages it first-touched
+ * - numaSortThenMerge: a multiway mergesort whose traffic stays on the local
+ *   node until the last pass: every thread sorts its own slice, the threads
+ *   of a node merge their slices into one sorted run on that node, and only
+ *   the final merge of the node runs reads across sockets. Threads are
+ *   assigned to nodes in team order, so run with OMP_PROC_BIND=close (or
+ *   spread) and OMP_PLACES=cores for the team to follow the node layout.
+ * Node policies are set with the raw mbind(2) system call, so there is no
+ * libnuma dependency; on a single-node machine every placement is a plain
+ * parallel first touch.
+ *
+ * A NumaBuffer can also ask for huge pages, which cuts TLB misses on the
+ * random-looking accesses of partitioning and merging: explicit ones
+ * (MAP_HUGETLB) when the system has reserved some, transparent ones
+ * (madvise(MADV_HUGEPAGE)) otherwise.
+ */
+
+#ifndef NUMA_BUFFER_H
+#define NUMA_BUFFER_H
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <fstream>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#include "omp_compat.h"
+#include "merge_sort.h"
+
+const size_t HUGE_PAGE_SIZE = 2 << 20;
+
+enum class NumaPlacement {
+    FirstTouch,  // node of the thread that owns the page in the static partition
+    Interleave   // round-robin over all nodes, page by page
+};
+
+// Ids of the online NUMA nodes, from /sys/devices/system/node/online
+// ("0", "0-1", "0,2-3"); {0} when the kernel does not report them
+inline const std::vector<int>& numaNodes() {
+    static const std::vector<int> nodes = [] {
+        std::vector<int> ids;
+        std::ifstream file("/sys/devices/system/node/online");
+        std::string list;
+        if (file >> list) {
+            size_t pos = 0;
+            while (pos < list.size()) {
+                size_t end = list.find(',', pos);
+                if (end == std::string::npos) end = list.size();
+                std::string item = list.substr(pos, end - pos);
+                size_t dash = item.find('-');
+                int low = std::atoi(item.c_str());
+                int high = dash == std::string::npos ? low : std::atoi(item.c_str() + dash + 1);
+                for (int id = low; id <= high && id < 64; id++) ids.push_back(id);
+                pos = end + 1;
+            }
+        }
+        if (ids.empty()) ids.push_back(0);
+        return ids;
+    }();
+    return nodes;
+}
+
+inline int numaNodeCount() {
+    return static_cast<int>(numaNodes().size());
+}
+
+// mbind(2) over the whole pages inside [data, data + bytes); false on failure
+inline bool numaBind(void* data, size_t bytes, int mode, uint64_t nodeMask, unsigned flags) {
+    const uintptr_t page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    uintptr_t begin = (reinterpret_cast<uintptr_t>(data) + page - 1) & ~(page - 1);
+    uintptr_t end = (reinterpret_cast<uintptr_t>(data) + bytes) & ~(page - 1);
+    if (begin >= end) return true;
+    unsigned long mask = static_cast<unsigned long>(nodeMask);
+    return syscall(SYS_mbind, begin, end - begin, mode, &mask, sizeof(mask) * 8, flags) == 0;
+}
+
+inline uint64_t numaAllNodesMask() {
+    uint64_t mask = 0;
+    for (int id : numaNodes()) mask |= 1ull << id;
+    return mask;
+}
+
+// Touches data[0, n) in the engines' static partition, one write per page
+template <typename T>
+void numaFirstTouch(T* data, size_t n) {
+    const size_t stride = std::max<size_t>(1, static_cast<size_t>(sysconf(_SC_PAGESIZE)) / sizeof(T));
+    #pragma omp parallel
+    {
+        const size_t p = static_cast<size_t>(ompNumThreads());
+        const size_t t = static_cast<size_t>(ompThreadNum());
+        const size_t begin = n * t / p, end = n * (t + 1) / p;
+        for (size_t i = begin; i < end; i += stride) data[i] = T();
+        if (begin < end) data[end - 1] = T();
+    }
+}
+
+// Copies src[0, n) to dst with one memcpy per thread over its static slice
+inline void parallelCopy(int* dst, const int* src, size_t n) {
+    #pragma omp parallel
+    {
+        const size_t p = static_cast<size_t>(ompNumThreads());
+        const size_t t = static_cast<size_t>(ompThreadNum());
+        const size_t begin = n * t / p, end = n * (t + 1) / p;
+        if (begin < end) std::memcpy(dst + begin, src + begin, (end - begin) * sizeof(int));
+    }
+}
+
+// Uninitialized buffer of n elements of a trivially constructible T, placed
+// as described above when it is created
+template <typename T>
+class NumaBuffer {
+public:
+    enum class HugePages { None, Transparent, Explicit };
+
+    explicit NumaBuffer(size_t n, NumaPlacement placement = NumaPlacement::FirstTouch, bool useHugePages = false)
+        : size_(n) {
+        bytes_ = std::max<size_t>(1, n * sizeof(T));
+        void* memory = MAP_FAILED;
+        if (useHugePages) {
+            // Needs reserved pages (vm.nr_hugepages); fails cleanly otherwise
+            size_t hugeBytes = (bytes_ + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+            memory = mmap(nullptr, hugeBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (memory != MAP_FAILED) {
+                bytes_ = hugeBytes;
+                pages_ = HugePages::Explicit;
+            }
+        }
+        if (memory == MAP_FAILED) {
+            memory = mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (memory == MAP_FAILED) {
+                std::cerr << "Error allocating " << bytes_ << " bytes" << std::endl;
+                exit(1);
+            }
+            if (useHugePages && madvise(memory, bytes_, MADV_HUGEPAGE) == 0) pages_ = HugePages::Transparent;
+        }
+        data_ = static_cast<T*>(memory);
+
+        // The interleave policy has to be set before the first touch
+        if (placement == NumaPlacement::Interleave && numaNodeCount() > 1) {
+            numaBind(memory, bytes_, MPOL_INTERLEAVE, numaAllNodesMask(), 0);
+        }
+        numaFirstTouch(data_, n);
+    }
+
+    ~NumaBuffer() {
+        if (data_ != nullptr) munmap(data_, bytes_);
+    }
+
+    NumaBuffer(const NumaBuffer&) = delete;
+    NumaBuffer& operator=(const NumaBuffer&) = delete;
+
+    T* data() { return data_; }
+    const T* data() const { return data_; }
+    size_t size() const { return size_; }
+    T& operator[](size_t i) { return data_[i]; }
+    T* begin() { return data_; }
+    T* end() { return data_ + size_; }
+
+    // What the buffer got when huge pages were requested
+    HugePages hugePages() const { return pages_; }
+
+private:
+    HugePages pages_ = HugePages::None;
+    T* data_ = nullptr;
+    size_t size_ = 0;
+    size_t bytes_ = 0;
+};
+
+// Sorts arr[0, N) as described above, with scratch holding at least N ints.
+// Thread t's slice of arr, and of scratch, is [N * t / p, N * (t + 1) / p).
+inline void numaSortThenMerge(int* arr, long long N, int* scratch) {
+    const int maxThreads = ompMaxThreads();
+    if (N < MERGE_SORT_SEQUENTIAL_THRESHOLD || maxThreads == 1) {
+        std::sort(arr, arr + N);
+        return;
+    }
+
+    std::vector<SortedRun> slices, nodeRuns;
+    std::vector<int> nodeOf;
+
+    #pragma omp parallel
+    {
+        const int numThreads = ompNumThreads();
+        const int tid = ompThreadNum();
+
+        #pragma omp single
+        {
+            const int numNodes = std::min(numaNodeCount(), numThreads);
+            slices.resize(numThreads);
+            nodeOf.resize(numThreads);
+            nodeRuns.assign(numNodes, {N, 0});
+            for (int t = 0; t < numThreads; t++) {
+                slices[t] = {N * t / numThreads, N * (t + 1) / numThreads};
+                nodeOf[t] = t * numNodes / numThreads;
+                SortedRun& run = nodeRuns[nodeOf[t]];
+                run.begin = std::min(run.begin, slices[t].begin);
+                run.end = std::max(run.end, slices[t].end);
+            }
+        }
+
+        // 1. Every thread sorts its own slice
+        std::sort(arr + slices[tid].begin, arr + slices[tid].end);
+        #pragma omp barrier
+
+        // 2. The threads of each node merge that node's slices into one run of
+        //    scratch, each writing the part of it that lies in its own slice
+        {
+            const SortedRun& node = nodeRuns[nodeOf[tid]];
+            std::vector<SortedRun> localRuns;
+            for (int t = 0; t < numThreads; t++) {
+                if (nodeOf[t] == nodeOf[tid]) localRuns.push_back(slices[t]);
+            }
+            std::vector<long long> from, to;
+            selectMultiwaySplit(arr, localRuns, slices[tid].begin - node.begin, from);
+            selectMultiwaySplit(arr, localRuns, slices[tid].end - node.begin, to);
+            mergeRuns(arr, from, to, scratch + slices[tid].begin);
+        }
+        #pragma omp barrier
+
+        // 3. The only cross-node pass: every thread merges its slice of the
+        //    output from the node runs back into arr
+        std::vector<long long> from, to;
+        selectMultiwaySplit(scratch, nodeRuns, slices[tid].begin, from);
+        selectMultiwaySplit(scratch, nodeRuns, slices[tid].end, to);
+        mergeRuns(scratch, from, to, arr + slices[tid].begin);
+    }
+}
+
+#endif // NUMA_BUFFER_H
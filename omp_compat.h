@@ -0,0 +1,53 @@
+/*
+ * File: omp_compat.h
+ *
+ * Description:
+ * Thin wrappers over the OpenMP runtime queries used by the shared headers, so
+ * they also compile without -fopenmp (as in the sequential sorter), where
+ * every parallel region runs on the calling thread alone.
+ */
+
+#ifndef OMP_COMPAT_H
+#define OMP_COMPAT_H
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Threads a new parallel region would use
+inline int ompMaxThreads() {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+// Threads in the current team (1 outside a parallel region)
+inline int ompNumThreads() {
+#ifdef _OPENMP
+    return omp_get_num_threads();
+#else
+    return 1;
+#endif
+}
+
+// Index of the calling thread in the current team
+inline int ompThreadNum() {
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+// Sets the thread count of later parallel regions; a no-op without OpenMP
+inline void ompSetNumThreads(int threads) {
+#ifdef _OPENMP
+    omp_set_num_threads(threads);
+#else
+    (void)threads;
+#endif
+}
+
+#endif // OMP_COMPAT_H
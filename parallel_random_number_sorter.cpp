@@ -9,9 +9,39 @@
  * generation, file I/O, and sorting using OpenMP. It performs the following tasks:
  * 1. Generates N random numbers in parallel and writes them to a CSV file.
  * 2. Reads the numbers from the file into memory.
- * 3. Sorts the numbers using a parallel implementation of QuickSort.
+ * 3. Sorts the numbers using a parallel implementation of QuickSort, or a
+ *    parallel counting sort when sampling finds only a few distinct keys
+ *    (--engine picks any other engine of sort_engines.h).
  * 4. Writes the sorted numbers to a new CSV file.
  *
+ * The run is configured on the command line (see sorter_cli.h): --n N skips
+ * the prompt, and --engine, --format, --threads and --seed pick the sort
+ * engine, the file format, the thread count and the seed. The quicksort
+ * cutoffs come from the per-host profile of complete_performance_analysis
+ * --tune when there is one, or from --profile PATH.
+ *
+ * With --external-memory MB the data never has to fit in memory: the input is
+ * generated block by block and sorted with the external merge sort of
+ * external_sort.h within that budget.
+ *
+ * With --top K or --range FIRST LAST only the requested ranks are put in
+ * order (see partial_sort.h) and only they are written to the output file.
+ *
+ * With --pipeline the stages overlap instead of running one after another:
+ * generation overlaps writing the input, chunks of the input are sorted while
+ * later chunks are still being read and parsed, and the final merge of the
+ * sorted chunks streams straight into the output writer.
+ *
+ * Every run ends by verifying its output (--no-verify skips it): one parallel
+ * pass checks that the result is in order and that its multiset checksum
+ * matches the one taken while the input was generated (see sort_verify.h).
+ * Outputs that only exist as files (--pipeline, --external-memory) are
+ * verified by streaming the output file back block by block.
+ *
+ * The key buffer is first-touched in parallel, in the same static partition
+ * the sort uses, so its pages are spread over the NUMA nodes of the threads
+ * that work on them (--interleave spreads them round-robin instead).
+ *
  * The program showcases the use of OpenMP for parallelizing computationally
  * intensive tasks and measures the execution time for performance comparison
  * with the sequential version.
@@ -24,111 +54,318 @@
 #include <algorithm>
 #include <omp.h>
 #include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "random_engine.h"
+#include "csv_io.h"
+#include "binary_io.h"
+#include "external_sort.h"
+#include "partial_sort.h"
+#include "numa_buffer.h"
+#include "sort_verify.h"
+#include "sort_engines.h"
+#include "sorter_cli.h"
 
 const char* INPUT_FILE = "random_numbers.csv";
 const char* OUTPUT_FILE = "sorted_numbers.csv";
+const char* BINARY_INPUT_FILE = "random_numbers.bin";
+const char* BINARY_OUTPUT_FILE = "sorted_numbers.bin";
 
-void generateRandomNumbers(int* numbers, int N, int maxValue) {
-    #pragma omp parallel for
-    for (int i = 0; i < N; i++) {
-        numbers[i] = rand() % maxValue + 1;
-    }
+// Values per chunk handed from the reader to the sorter in --pipeline mode
+const long long PIPELINE_CHUNK_VALUES = 1 << 20;
+
+// Each thread draws from its own Philox counter range, so the output depends
+// only on the seed and not on the number of threads. Returns the checksum of
+// the generated values.
+uint64_t generateRandomNumbers(int* numbers, int N, int maxValue, uint64_t seed) {
+    uint64_t checksum;
+    fillRandomParallel(numbers, N, 1, maxValue, seed, 0, &checksum);
+    return checksum;
 }
 
+// Formats per-thread slices with std::to_chars and writes them with pwrite (see csv_io.h)
 void writeToFile(const char* filename, int* numbers, int N) {
-    std::ofstream file(filename);
-    if (!file.is_open()) {
-        std::cerr << "Error opening file: " << filename << std::endl;
-        exit(1);
-    }
+    writeCsvParallel(filename, numbers, N);
+}
 
-    for (int i = 0; i < N - 1; i++) {
-        file << numbers[i] << ",";
-    }
-    file << numbers[N - 1];
+// Memory-maps the file and parses it in per-thread chunks (see csv_io.h)
+void readFromFile(const char* filename, int* numbers, int N) {
+    readCsvParallel(filename, numbers, N);
+}
+
+// Engine of every in-memory sort, set with --engine. The default "auto"
+// sorts inputs that sample as low-cardinality (such as the default 1..1000
+// keys) with the O(N) parallel counting sort instead of quicksort, whose
+// partitions degrade on heavy duplicates.
+SortEngine sortEngine = SortEngine::Auto;
 
-    file.close();
+// Scratch of the numa-merge engine for the in-memory paths, allocated before
+// the timer starts; without it (external sort runs) the engine allocates its own
+int* sortScratch = nullptr;
+
+void sortNumbers(int* numbers, int N) {
+    sortWithEngine(sortEngine, numbers, N, sortScratch);
 }
 
-void readFromFile(const char* filename, int* numbers, int N) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
+// Puts ranks [first, last) of numbers[0, N) in sorted order at numbers + first.
+// A small prefix comes from per-thread bounded heaps, any other range from
+// parallel selection; the full range is an ordinary sort.
+void sortRankRange(int* numbers, int N, int first, int last) {
+    if (first == 0 && last == N) {
+        sortNumbers(numbers, N);
+    } else if (first == 0 && last <= TOP_K_HEAP_LIMIT) {
+        std::vector<int> smallest(last);
+        parallelTopK(numbers, N, last, smallest.data());
+        std::copy(smallest.begin(), smallest.end(), numbers);
+    } else {
+        parallelPartialSort(numbers, N, first, last);
+    }
+}
+
+// Generates the dataset block by block straight into filename (in the binary
+// or CSV format), so it never has to fit in memory. Returns its checksum.
+uint64_t generateRandomFile(const char* filename, bool binary, int N, int maxValue, uint64_t seed, size_t memoryBudget) {
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
         std::cerr << "Error opening file: " << filename << std::endl;
         exit(1);
     }
 
-    for (int i = 0; i < N; i++) {
-        if (file.peek() == EOF) break;
-        file >> numbers[i];
-        if (file.peek() == ',') file.ignore();
+    // Two blocks of values plus their formatted text
+    long long blockValues = std::max<long long>(EXTERNAL_MIN_BLOCK_VALUES, memoryBudget / (8 * sizeof(int)));
+    uint64_t checksum = 0;
+    {
+        BlockWriter writer(fd, binary ? sizeof(BinaryHeader) : 0, !binary, blockValues, filename);
+        for (long long first = 0; first < N; first += blockValues) {
+            int n = static_cast<int>(std::min<long long>(blockValues, N - first));
+            uint64_t blockChecksum;
+            fillRandomParallel(writer.block(), n, 1, maxValue, seed, first, &blockChecksum);
+            checksum += blockChecksum;
+            writer.flush(n);
+        }
+    }
+
+    if (binary) {
+        BinaryHeader header = makeBinaryHeader(static_cast<uint64_t>(N), checksum, false);
+        pwriteAll(fd, reinterpret_cast<const char*>(&header), sizeof(header), 0, filename);
     }
+    close(fd);
+    return checksum;
+}
 
-    file.close();
+// Streams filename (in either format) through a SortVerifier, blockValues
+// values at a time
+SortVerifier verifySortedFile(const char* filename, long long blockValues) {
+    DatasetReader reader(filename);
+    std::vector<int> block(blockValues);
+    SortVerifier verifier;
+    while (long long n = reader.read(block.data(), blockValues)) {
+        verifier.add(block.data(), n);
+    }
+    return verifier;
 }
 
-void parallelQuickSort(int* arr, int left, int right) {
-    if (left < right) {
-        int pivot = arr[right];
-        int i = left - 1;
+// Reads inputFile into numbers on a separate thread while already-read chunks
+// are sorted, then merges the sorted chunks straight into outputFile, which
+// is written in the input's format. Returns the number of values sorted.
+int pipelinedSort(const char* inputFile, const char* outputFile, int* numbers, int N) {
+    DatasetReader reader(inputFile);
+    std::vector<std::pair<long long, long long>> chunks;
+    std::mutex mutex;
+    std::condition_variable chunkReady;
+    bool readDone = false;
 
-        for (int j = left; j < right; j++) {
-            if (arr[j] <= pivot) {
-                i++;
-                std::swap(arr[i], arr[j]);
+    std::thread readerThread([&] {
+        long long total = 0;
+        while (total < N) {
+            long long n = reader.read(numbers + total, std::min<long long>(PIPELINE_CHUNK_VALUES, N - total));
+            if (n == 0) break;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                chunks.push_back({total, total + n});
             }
+            chunkReady.notify_one();
+            total += n;
         }
-        std::swap(arr[i + 1], arr[right]);
-
-        int partition = i + 1;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            readDone = true;
+        }
+        chunkReady.notify_one();
+    });
 
-        #pragma omp task
-        parallelQuickSort(arr, left, partition - 1);
+    // Sort every chunk as soon as the reader has published it
+    std::vector<std::unique_ptr<MemoryRun>> runs;
+    long long count = 0;
+    while (true) {
+        std::pair<long long, long long> chunk;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            chunkReady.wait(lock, [&] { return runs.size() < chunks.size() || readDone; });
+            if (runs.size() == chunks.size()) break;
+            chunk = chunks[runs.size()];
+        }
+        sortNumbers(numbers + chunk.first, static_cast<int>(chunk.second - chunk.first));
+        runs.emplace_back(new MemoryRun(numbers + chunk.first, numbers + chunk.second));
+        count = chunk.second;
+    }
+    readerThread.join();
 
-        #pragma omp task
-        parallelQuickSort(arr, partition + 1, right);
+    off_t payloadOffset;
+    int fd = openSortedOutput(outputFile, reader.binary(), count, binaryChecksum(numbers, count), payloadOffset);
+    {
+        BlockWriter writer(fd, payloadOffset, !reader.binary(), EXTERNAL_MIN_BLOCK_VALUES * 4, outputFile);
+        mergeIntoWriter(runs, writer);
     }
+    close(fd);
+    return static_cast<int>(count);
 }
 
-int main() {
-    int N;
-    std::cout << "Enter the number of random numbers to generate: ";
-    std::cin >> N;
+int main(int argc, char* argv[]) {
+    // --n, --engine, --format, --threads, --seed and --profile are described in sorter_cli.h,
+    // --binary is short for --format binary (see binary_io.h),
+    // --quicksort is short for --engine parallel-quicksort,
+    // --external-memory MB sorts out of core within MB megabytes (see external_sort.h),
+    // --pipeline overlaps reading, sorting and writing,
+    // --top K and --range FIRST LAST only sort and write those ranks,
+    // --interleave spreads the key buffer's pages over all NUMA nodes,
+    // --numa-merge is short for --engine numa-merge (see numa_buffer.h),
+    // --no-verify skips the verification of the output (see sort_verify.h)
+    SorterOptions options;
+    bool verify = true;
+    NumaPlacement placement = NumaPlacement::FirstTouch;
+    bool pipeline = false;
+    size_t externalBudget = 0;
+    long long rankFirst = 0;
+    long long rankLast = -1;  // -1: through the last value
+    for (int a = 1; a < argc; a++) {
+        if (parseSorterOption(argc, argv, a, options)) continue;
+        if (std::strcmp(argv[a], "--binary") == 0) options.binary = true;
+        else if (std::strcmp(argv[a], "--quicksort") == 0) options.engine = SortEngine::ParallelQuickSort;
+        else if (std::strcmp(argv[a], "--pipeline") == 0) pipeline = true;
+        else if (std::strcmp(argv[a], "--interleave") == 0) placement = NumaPlacement::Interleave;
+        else if (std::strcmp(argv[a], "--numa-merge") == 0) options.engine = SortEngine::NumaMerge;
+        else if (std::strcmp(argv[a], "--no-verify") == 0) verify = false;
+        else if (std::strcmp(argv[a], "--top") == 0 && a + 1 < argc) rankLast = std::atoll(argv[++a]);
+        else if (std::strcmp(argv[a], "--range") == 0 && a + 2 < argc) {
+            rankFirst = std::atoll(argv[++a]);
+            rankLast = std::atoll(argv[++a]);
+        }
+        else if (std::strcmp(argv[a], "--external-memory") == 0 && a + 1 < argc) {
+            externalBudget = static_cast<size_t>(std::max(1, std::atoi(argv[++a]))) << 20;
+        }
+    }
+    const bool binaryFormat = options.binary;
+    const char* inputFile = binaryFormat ? BINARY_INPUT_FILE : INPUT_FILE;
+    const char* outputFile = binaryFormat ? BINARY_OUTPUT_FILE : OUTPUT_FILE;
+    sortEngine = options.engine;
+
+    int N = resolveSorterCount(options);
+    const uint64_t seed = options.seed;  // Seed of the random number generator
+
+    // Requested ranks, clamped to [0, N]
+    int first = static_cast<int>(std::min<long long>(std::max(rankFirst, 0LL), N));
+    int last = rankLast < 0 ? N : static_cast<int>(std::min<long long>(std::max(rankLast, rankFirst), N));
+    if (last - first != N && (pipeline || externalBudget > 0)) {
+        std::cerr << "Error: --top and --range are not supported with --pipeline or --external-memory" << std::endl;
+        return 1;
+    }
+
+    if (externalBudget > 0) {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        uint64_t checksum = generateRandomFile(inputFile, binaryFormat, N, 1000, seed, externalBudget);
+        ExternalSortStats stats = externalSort(inputFile, outputFile, externalBudget, [](int* run, long long n) {
+            sortNumbers(run, static_cast<int>(n));
+        });
 
-    srand(time(nullptr));  // Seed the random number generator
+        std::chrono::duration<double> diff = std::chrono::high_resolution_clock::now() - start;
+        std::cout << "Time taken: " << diff.count() << " seconds" << std::endl;
+        std::cout << "Seed: " << seed << std::endl;
+        std::cout << "External sort: " << stats.values << " values in " << stats.runs << " runs, "
+                  << stats.mergePasses << " merge passes" << std::endl;
+        std::cout << "Input file: " << inputFile << std::endl;
+        std::cout << "Output file: " << outputFile << std::endl;
+        if (verify) {
+            // One block of the size generateRandomFile writes, well within the budget
+            long long blockValues = std::max<long long>(EXTERNAL_MIN_BLOCK_VALUES, externalBudget / (8 * sizeof(int)));
+            if (!reportVerification(verifySortedFile(outputFile, blockValues), N, &checksum)) return 1;
+        }
+        return 0;
+    }
 
-    // Allocate memory on the heap
-    int* numbers = new int[N];
+    // Allocate memory, first-touched in parallel so that each thread's slice
+    // of the keys starts out on its own NUMA node (see numa_buffer.h)
+    NumaBuffer<int> buffer(N, placement);
+    int* numbers = buffer.data();
+
+    // The numa-merge engine's scratch, placed the same way
+    NumaBuffer<int> scratch(sortEngine == SortEngine::NumaMerge ? N : 0, placement);
+    if (sortEngine == SortEngine::NumaMerge) sortScratch = scratch.data();
 
     auto start = std::chrono::high_resolution_clock::now();
 
-    // Generate random numbers and write to file
-    generateRandomNumbers(numbers, N, 1000);  // Generating numbers between 1 and 1000
-    writeToFile(INPUT_FILE, numbers, N);
+    // Checksum of the input, taken as it is generated
+    uint64_t checksum = 0;
 
-    // Read numbers from file
-    readFromFile(INPUT_FILE, numbers, N);
+    if (pipeline) {
+        // Generation overlaps writing (in blocks of one chunk), reading
+        // overlaps sorting, and the merge overlaps writing the output
+        checksum = generateRandomFile(inputFile, binaryFormat, N, 1000, seed, PIPELINE_CHUNK_VALUES * 8 * sizeof(int));
+        pipelinedSort(inputFile, outputFile, numbers, N);
+    } else {
+        // Generate random numbers and write to file
+        checksum = generateRandomNumbers(numbers, N, 1000, seed);  // Generating numbers between 1 and 1000
 
-    // Sort the numbers using parallel quicksort
-    #pragma omp parallel
-    {
-        #pragma omp single
-        parallelQuickSort(numbers, 0, N - 1);
-    }
+        if (binaryFormat) {
+            writeBinaryFile(inputFile, numbers, N, false);
+
+            // Map the input and sort it in place, without parsing or copying
+            MappedBinaryFile input(inputFile);
+            sortRankRange(input.data(), input.size(), first, last);
+            writeBinaryFile(outputFile, input.data() + first, last - first, true);
+        } else {
+            writeToFile(inputFile, numbers, N);
+
+            // Read numbers from file
+            readFromFile(inputFile, numbers, N);
 
-    // Write sorted numbers to output file
-    writeToFile(OUTPUT_FILE, numbers, N);
+            // Sort the numbers using parallel quicksort
+            sortRankRange(numbers, N, first, last);
+
+            // Write sorted numbers to output file
+            writeToFile(outputFile, numbers + first, last - first);
+        }
+    }
 
     auto end = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> diff = end - start;
 
     std::cout << "Time taken: " << diff.count() << " seconds" << std::endl;
-
-    // Clean up
-    delete[] numbers;
+    std::cout << "Seed: " << seed << std::endl;
 
     std::cout << "Random numbers have been generated, sorted, and written to files." << std::endl;
-    std::cout << "Input file: " << INPUT_FILE << std::endl;
-    std::cout << "Output file: " << OUTPUT_FILE << std::endl;
+    std::cout << "Input file: " << inputFile << std::endl;
+    std::cout << "Output file: " << outputFile << std::endl;
 
+    if (verify) {
+        // Only a full sort keeps the input's checksum; a rank range is only
+        // checked for order
+        SortVerifier verifier;
+        if (binaryFormat) {
+            // Verified where it was written, through a mapping of the file
+            MappedBinaryFile output(outputFile);
+            verifier = verifySorted(output.data(), output.size());
+        } else if (pipeline) {
+            verifier = verifySortedFile(outputFile, PIPELINE_CHUNK_VALUES);
+        } else {
+            verifier = verifySorted(numbers + first, last - first);
+        }
+        if (!reportVerification(verifier, last - first, last - first == N ? &checksum : nullptr)) return 1;
+    }
     return 0;
 }
@@ -0,0 +1,93 @@
+/*
+ * File: partial_sort.h
+ *
+ * Description:
+ * Selection and partial sorting for rank queries that do not need the whole
+ * array in order:
+ * - parallelNthElement: quickselect whose large ranges are partitioned by the
+ *   whole thread team (see partition.h), finishing with std::nth_element.
+ *   Expected O(N).
+ * - parallelTopK: the smallest k values, for small k. Every thread keeps a
+ *   bounded max-heap of the k smallest keys of its slice, and the heaps are
+ *   merged at the end. O(N log k) with one pass over the input.
+ * - parallelPartialSort: sorts only ranks [first, last): two selections
+ *   isolate the range, and then only those last - first keys are sorted.
+ */
+
+#ifndef PARTIAL_SORT_H
+#define PARTIAL_SORT_H
+
+#include <vector>
+#include <algorithm>
+#include "omp_compat.h"
+#include "partition.h"
+
+// Largest k for which parallelTopK's per-thread heaps beat a selection
+const int TOP_K_HEAP_LIMIT = 1 << 16;
+
+// Rearranges arr[left, right] so that arr[k] holds the key a full sort would
+// put there, with no larger key before it and no smaller key after it
+inline void parallelNthElement(int* arr, int left, int right, int k) {
+    while (right - left + 1 > PARALLEL_PARTITION_THRESHOLD) {
+        PartitionBounds bounds = parallelPartitionRange(arr, left, right);
+        if (k < bounds.lt) right = bounds.lt - 1;
+        else if (k > bounds.gt) left = bounds.gt + 1;
+        else return;
+    }
+    std::nth_element(arr + left, arr + k, arr + right + 1);
+}
+
+// Writes the k smallest keys of arr[0, N) to out in ascending order
+inline void parallelTopK(const int* arr, int N, int k, int* out) {
+    k = std::min(k, N);
+    if (k <= 0) return;
+
+    std::vector<std::vector<int>> heaps(ompMaxThreads());
+    #pragma omp parallel
+    {
+        std::vector<int>& heap = heaps[ompThreadNum()];
+        heap.reserve(k);
+
+        #pragma omp for schedule(static)
+        for (int i = 0; i < N; i++) {
+            if (static_cast<int>(heap.size()) < k) {
+                heap.push_back(arr[i]);
+                std::push_heap(heap.begin(), heap.end());
+            } else if (arr[i] < heap.front()) {
+                std::pop_heap(heap.begin(), heap.end());
+                heap.back() = arr[i];
+                std::push_heap(heap.begin(), heap.end());
+            }
+        }
+    }
+
+    // At most threads * k candidates are left
+    std::vector<int> candidates;
+    for (const std::vector<int>& heap : heaps) candidates.insert(candidates.end(), heap.begin(), heap.end());
+    std::nth_element(candidates.begin(), candidates.begin() + (k - 1), candidates.end());
+    std::sort(candidates.begin(), candidates.begin() + k);
+    std::copy(candidates.begin(), candidates.begin() + k, out);
+}
+
+// Leaves arr[first, last) exactly as a full sort of arr[0, N) would, with
+// smaller keys before the range and larger ones after it in no order
+inline void parallelPartialSort(int* arr, int N, int first, int last) {
+    first = std::max(first, 0);
+    last = std::min(last, N);
+    if (first >= last) return;
+
+    if (first > 0) parallelNthElement(arr, 0, N - 1, first);
+    if (last < N) parallelNthElement(arr, first, N - 1, last - 1);
+
+    std::vector<IndexRange> pieces = splitLargeRanges(arr, first, last - 1);
+    #pragma omp parallel
+    {
+        #pragma omp single
+        for (const IndexRange& piece : pieces) {
+            #pragma omp task
+            std::sort(arr + piece.left, arr + piece.right + 1);
+        }
+    }
+}
+
+#endif // PARTIAL_SORT_H
@@ -0,0 +1,272 @@
+/*
+ * File: partition.h
+ *
+ * Description:
+ * Partitioning engine shared by the quicksort variants. The pivot is the
+ * median of three samples (first, middle, last), or Tukey's ninther (median of
+ * three medians of three) for ranges above NINTHER_THRESHOLD, so sorted and
+ * reverse-sorted inputs no longer hit the worst case. The ninther's samples
+ * sit at hashed offsets instead of evenly spaced ones, so periodic inputs do
+ * not hit it either. Partitioning is three-way (Dijkstra's Dutch national
+ * flag): keys equal to the pivot are gathered in the middle and excluded from
+ * both recursive calls, so inputs with many duplicates shrink quickly instead
+ * of going quadratic.
+ *
+ * Ranges above PARALLEL_PARTITION_THRESHOLD are partitioned by the whole
+ * thread team instead of a single thread: every thread partitions its own
+ * block in place, the blocks' misplaced runs (large keys left of the global
+ * split, small keys right of it) are paired up through a prefix-sum, and a
+ * parallel cleanup pass swaps them across. splitLargeRanges() applies this to
+ * the top levels of the recursion so that task-based sorting only starts once
+ * the remaining pieces are small.
+ */
+
+#ifndef PARTITION_H
+#define PARTITION_H
+
+#include <algorithm>
+#include <vector>
+#include <cstdint>
+#include "omp_compat.h"
+
+const int NINTHER_THRESHOLD = 128;
+const int PARALLEL_PARTITION_THRESHOLD = 1 << 21;
+
+// Result of a three-way partition of arr[left, right]:
+// arr[left, lt) < pivot, arr[lt, gt] == pivot, arr(gt, right] > pivot
+struct PartitionBounds {
+    int lt;
+    int gt;
+};
+
+// Key extractor for bare int arrays
+struct IdentityKey {
+    int operator()(int value) const { return value; }
+};
+
+// The scalar pivot, partition and insertion steps are templates on the
+// element type and key extractor, so the record engines (record_sort.h) share
+// them with the int engines below; only the SIMD kernels are int-only.
+template <typename T, typename KeyOf>
+int medianOfThreeBy(const T* arr, int a, int b, int c, KeyOf keyOf) {
+    int ka = keyOf(arr[a]), kb = keyOf(arr[b]), kc = keyOf(arr[c]);
+    if (ka < kb) {
+        if (kb < kc) return b;
+        return ka < kc ? c : a;
+    }
+    if (ka < kc) return a;
+    return kb < kc ? c : b;
+}
+
+// Positions of the ninther's nine samples in arr[left, right], one in each
+// ninth of the range at an offset hashed from (left, right, k). Evenly spaced
+// samples all land on the same phase of periodic inputs such as sawtooths,
+// which makes the pivot an extreme key at every level of the recursion.
+inline void nintherSamples(int left, int right, int* samples) {
+    const int slot = (right - left + 1) / 9;
+    const uint64_t range = (static_cast<uint64_t>(static_cast<uint32_t>(left)) << 32) | static_cast<uint32_t>(right);
+    for (int k = 0; k < 9; k++) {
+        uint64_t h = range + (k + 1) * 0x9E3779B97F4A7C15ull;  // splitmix64 finalizer
+        h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ull;
+        h = (h ^ (h >> 27)) * 0x94D049BB133111EBull;
+        h ^= h >> 31;
+        samples[k] = left + k * slot + static_cast<int>(h % static_cast<uint64_t>(slot));
+    }
+}
+
+// Returns the index of the pivot for arr[left, right]
+template <typename T, typename KeyOf>
+int choosePivotIndexBy(const T* arr, int left, int right, KeyOf keyOf) {
+    int mid = left + (right - left) / 2;
+    if (right - left < NINTHER_THRESHOLD) {
+        return medianOfThreeBy(arr, left, mid, right, keyOf);
+    }
+
+    int s[9];
+    nintherSamples(left, right, s);
+    int m1 = medianOfThreeBy(arr, s[0], s[1], s[2], keyOf);
+    int m2 = medianOfThreeBy(arr, s[3], s[4], s[5], keyOf);
+    int m3 = medianOfThreeBy(arr, s[6], s[7], s[8], keyOf);
+    return medianOfThreeBy(arr, m1, m2, m3, keyOf);
+}
+
+// Three-way partition of arr[left, right] around the key pivot
+template <typename T, typename KeyOf>
+PartitionBounds partitionThreeWayBy(T* arr, int left, int right, int pivot, KeyOf keyOf) {
+    int lt = left, i = left, gt = right;
+    while (i <= gt) {
+        int key = keyOf(arr[i]);
+        if (key < pivot) {
+            std::swap(arr[lt++], arr[i++]);
+        } else if (key > pivot) {
+            std::swap(arr[i], arr[gt--]);
+        } else {
+            i++;
+        }
+    }
+    return {lt, gt};
+}
+
+// Insertion sort of arr[left, right], used for small leaves of the recursion
+template <typename T, typename KeyOf>
+void insertionSortBy(T* arr, int left, int right, KeyOf keyOf) {
+    for (int i = left + 1; i <= right; i++) {
+        T value = arr[i];
+        int key = keyOf(value);
+        int j = i - 1;
+        while (j >= left && keyOf(arr[j]) > key) {
+            arr[j + 1] = arr[j];
+            j--;
+        }
+        arr[j + 1] = value;
+    }
+}
+
+inline int medianOfThree(const int* arr, int a, int b, int c) {
+    return medianOfThreeBy(arr, a, b, c, IdentityKey());
+}
+
+inline int choosePivotIndex(const int* arr, int left, int right) {
+    return choosePivotIndexBy(arr, left, right, IdentityKey());
+}
+
+// Returns the pivot value for arr[left, right]
+inline int choosePivot(const int* arr, int left, int right) {
+    return arr[choosePivotIndex(arr, left, right)];
+}
+
+inline PartitionBounds partitionThreeWay(int* arr, int left, int right, int pivot) {
+    return partitionThreeWayBy(arr, left, right, pivot, IdentityKey());
+}
+
+// Picks a pivot and partitions arr[left, right] three ways
+inline PartitionBounds partitionRange(int* arr, int left, int right) {
+    return partitionThreeWay(arr, left, right, choosePivot(arr, left, right));
+}
+
+inline void insertionSort(int* arr, int left, int right) {
+    insertionSortBy(arr, left, right, IdentityKey());
+}
+
+// Inclusive index range still to be sorted, tagged with its recursion depth
+struct IndexRange {
+    int left;
+    int right;
+    int depth;
+};
+
+// Run of misplaced elements found by one block, and where it starts in the
+// global enumeration of misplaced elements on its side of the split
+struct MisplacedRun {
+    long long begin;
+    long long end;
+    long long rank;
+};
+
+// Index of the k-th misplaced element in a list of runs ordered by rank
+inline long long misplacedIndex(const std::vector<MisplacedRun>& runs, size_t& run, long long k) {
+    while (k >= runs[run].rank + (runs[run].end - runs[run].begin)) run++;
+    return runs[run].begin + (k - runs[run].rank);
+}
+
+// Parallel two-way partition of arr[left, right]: elements satisfying pred
+// move before the returned split index, the rest after it. Opens its own
+// parallel region, so it must be called outside of one.
+template <typename Pred>
+int parallelPartitionBy(int* arr, int left, int right, Pred pred) {
+    const long long n = static_cast<long long>(right) - left + 1;
+    const int maxBlocks = ompMaxThreads();
+    std::vector<long long> blockBegin(maxBlocks + 1), blockMid(maxBlocks);
+    std::vector<MisplacedRun> leftRuns, rightRuns;
+    long long split = 0, misplaced = 0;
+    int numBlocks = 1;
+
+    #pragma omp parallel
+    {
+        int tid = ompThreadNum();
+
+        #pragma omp single
+        {
+            numBlocks = ompNumThreads();
+            for (int b = 0; b <= numBlocks; b++) blockBegin[b] = left + n * b / numBlocks;
+        }
+
+        // Each thread partitions its own block in place
+        blockMid[tid] = std::partition(arr + blockBegin[tid], arr + blockBegin[tid + 1], pred) - arr;
+        #pragma omp barrier
+
+        // Pair up the runs on the wrong side of the global split
+        #pragma omp single
+        {
+            split = left;
+            for (int b = 0; b < numBlocks; b++) split += blockMid[b] - blockBegin[b];
+
+            long long leftRank = 0, rightRank = 0;
+            for (int b = 0; b < numBlocks; b++) {
+                long long bigBegin = blockMid[b], bigEnd = std::min(blockBegin[b + 1], split);
+                if (bigBegin < bigEnd) {
+                    leftRuns.push_back({bigBegin, bigEnd, leftRank});
+                    leftRank += bigEnd - bigBegin;
+                }
+                long long smallBegin = std::max(blockBegin[b], split), smallEnd = blockMid[b];
+                if (smallBegin < smallEnd) {
+                    rightRuns.push_back({smallBegin, smallEnd, rightRank});
+                    rightRank += smallEnd - smallBegin;
+                }
+            }
+            misplaced = leftRank;
+        }
+
+        // Cleanup: the k-th misplaced large key swaps with the k-th misplaced
+        // small key, with the pairs divided evenly between threads
+        long long kBegin = misplaced * tid / numBlocks;
+        long long kEnd = misplaced * (tid + 1) / numBlocks;
+        size_t leftRun = 0, rightRun = 0;
+        for (long long k = kBegin; k < kEnd; k++) {
+            std::swap(arr[misplacedIndex(leftRuns, leftRun, k)], arr[misplacedIndex(rightRuns, rightRun, k)]);
+        }
+    }
+
+    return static_cast<int>(split);
+}
+
+// Three-way partition of arr[left, right] by the whole thread team. The
+// second sweep that gathers pivot-equal keys only runs when they are common or
+// when nothing is smaller than the pivot (so that the range always shrinks).
+inline PartitionBounds parallelPartitionRange(int* arr, int left, int right) {
+    int pivot = choosePivot(arr, left, right);
+    int lt = parallelPartitionBy(arr, left, right, [pivot](int x) { return x < pivot; });
+
+    long long equal = 0;
+    #pragma omp parallel for reduction(+:equal) schedule(static)
+    for (int i = lt; i <= right; i++) equal += arr[i] == pivot;
+
+    if (lt > left && equal * 64 < static_cast<long long>(right) - lt + 1) {
+        return {lt, lt - 1};
+    }
+    int gt = parallelPartitionBy(arr, lt, right, [pivot](int x) { return x == pivot; }) - 1;
+    return {lt, gt};
+}
+
+// Partitions arr[left, right] in parallel, level by level, until every piece
+// is at most PARALLEL_PARTITION_THRESHOLD elements, and returns those pieces
+inline std::vector<IndexRange> splitLargeRanges(int* arr, int left, int right) {
+    std::vector<IndexRange> pending = {{left, right, 0}};
+    std::vector<IndexRange> pieces;
+    while (!pending.empty()) {
+        IndexRange range = pending.back();
+        pending.pop_back();
+        if (range.left >= range.right) continue;
+        if (range.right - range.left + 1 <= PARALLEL_PARTITION_THRESHOLD) {
+            pieces.push_back(range);
+            continue;
+        }
+
+        PartitionBounds bounds = parallelPartitionRange(arr, range.left, range.right);
+        pending.push_back({range.left, bounds.lt - 1, range.depth + 1});
+        pending.push_back({bounds.gt + 1, range.right, range.depth + 1});
+    }
+    return pieces;
+}
+
+#endif // PARTITION_H
@@ -0,0 +1,219 @@
+/*
+ * File: perf_counters.h
+ *
+ * Description:
+ * Optional hardware counter instrumentation for the benchmark runs, built on
+ * perf_event_open(2). Every thread of the process (OpenMP team, work-stealing
+ * pools, sort context workers) gets its own counters, opened by thread id:
+ * - one event group with cycles, instructions, last-level cache misses and
+ *   branch misses, counted in user space only (allowed for the own process
+ *   at the default perf_event_paranoid level of 2)
+ * - a task-clock software event, the thread's on-CPU time
+ * When the PMU has more events to count than counters, the kernel rotates the
+ * groups, so every group is read with the time it was enabled and the time it
+ * actually ran, and its counts are scaled by enabled / running. Groups that
+ * never ran contribute nothing and are counted in unscheduledGroups.
+ * A run's busy time is the task-clock summed over threads, and its idle time
+ * is wall time minus task-clock summed over the threads that ran at all, so
+ * pools belonging to other engines do not count as idle. OpenMP threads that
+ * spin while waiting show up as busy; run with OMP_WAIT_POLICY=passive to
+ * count waiting as idle.
+ *
+ * Whatever the kernel refuses is left out: without a PMU (as in most VMs) the
+ * hardware counters read as unavailable, and without perf_event_open at all
+ * busy times fall back to /proc/self/task/<tid>/schedstat.
+ */
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+const int PERF_HARDWARE_EVENTS = 4;
+
+// Counter totals of one run; hardware is false when the PMU was unavailable
+struct CounterSample {
+    bool hardware = false;
+    double cycles = 0;
+    double instructions = 0;
+    double llcMisses = 0;
+    double branchMisses = 0;
+    int unscheduledGroups = 0;        // hardware groups that never got on the PMU
+    double busy = 0;                  // seconds on CPU, all threads
+    double idle = 0;                  // seconds off CPU, threads that ran
+    std::vector<double> threadBusy;   // seconds on CPU per thread that ran
+};
+
+inline int openPerfEvent(uint32_t type, uint64_t config, pid_t tid, int groupFd) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = groupFd == -1 ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, tid, -1, groupFd, 0));
+}
+
+// Nanoseconds thread tid has spent on a CPU, from schedstat; -1 if unreadable
+inline long long readSchedstatRuntime(pid_t tid) {
+    std::string path = "/proc/self/task/" + std::to_string(tid) + "/schedstat";
+    FILE* file = std::fopen(path.c_str(), "r");
+    if (file == nullptr) return -1;
+    long long runtime = -1;
+    if (std::fscanf(file, "%lld", &runtime) != 1) runtime = -1;
+    std::fclose(file);
+    return runtime;
+}
+
+class PerfCounters {
+public:
+    PerfCounters() {
+        refreshThreads();
+    }
+
+    ~PerfCounters() {
+        for (ThreadCounters& thread : threads_) closeThread(thread);
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    // True when cycles, instructions and misses can be counted
+    bool hardwareAvailable() const {
+        for (const ThreadCounters& thread : threads_) {
+            if (thread.group != -1) return true;
+        }
+        return false;
+    }
+
+    // Opens counters for threads started since the last call, such as the
+    // workers of a pool created after this object
+    void refreshThreads() {
+        DIR* dir = opendir("/proc/self/task");
+        if (dir == nullptr) return;
+        while (dirent* entry = readdir(dir)) {
+            if (entry->d_name[0] == '.') continue;
+            pid_t tid = static_cast<pid_t>(std::atoi(entry->d_name));
+            bool known = false;
+            for (const ThreadCounters& thread : threads_) known = known || thread.tid == tid;
+            if (!known) threads_.push_back(openThread(tid));
+        }
+        closedir(dir);
+    }
+
+    // Resets and enables every counter
+    void start() {
+        for (ThreadCounters& thread : threads_) {
+            if (thread.group != -1) {
+                ioctl(thread.group, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+                ioctl(thread.group, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+            }
+            if (thread.clock != -1) {
+                ioctl(thread.clock, PERF_EVENT_IOC_RESET, 0);
+                ioctl(thread.clock, PERF_EVENT_IOC_ENABLE, 0);
+            }
+            thread.runtimeStart = thread.clock == -1 ? readSchedstatRuntime(thread.tid) : 0;
+        }
+    }
+
+    // Disables the counters and returns their totals for a run of wallSeconds
+    CounterSample stop(double wallSeconds) {
+        CounterSample sample;
+        sample.hardware = hardwareAvailable();
+        for (ThreadCounters& thread : threads_) {
+            if (thread.group != -1) {
+                ioctl(thread.group, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+                // nr, time enabled, time running, then one value per event
+                uint64_t values[3 + PERF_HARDWARE_EVENTS] = {};
+                if (read(thread.group, values, sizeof(values)) == static_cast<ssize_t>(sizeof(values))) {
+                    if (values[2] == 0) {
+                        if (values[1] > 0) sample.unscheduledGroups++;
+                    } else {
+                        const double scale = static_cast<double>(values[1]) / static_cast<double>(values[2]);
+                        sample.cycles += static_cast<double>(values[3]) * scale;
+                        sample.instructions += static_cast<double>(values[4]) * scale;
+                        sample.llcMisses += static_cast<double>(values[5]) * scale;
+                        sample.branchMisses += static_cast<double>(values[6]) * scale;
+                    }
+                }
+            }
+
+            long long runtime = -1;
+            if (thread.clock != -1) {
+                ioctl(thread.clock, PERF_EVENT_IOC_DISABLE, 0);
+                uint64_t values[4] = {};
+                if (read(thread.clock, values, sizeof(values)) == static_cast<ssize_t>(sizeof(values))) {
+                    runtime = static_cast<long long>(values[3]);
+                }
+            } else if (thread.runtimeStart >= 0) {
+                long long end = readSchedstatRuntime(thread.tid);
+                if (end >= 0) runtime = end - thread.runtimeStart;
+            }
+
+            if (runtime > 0) {
+                double busy = runtime * 1e-9;
+                sample.threadBusy.push_back(busy);
+                sample.busy += busy;
+                sample.idle += std::max(0.0, wallSeconds - busy);
+            }
+        }
+        return sample;
+    }
+
+private:
+    struct ThreadCounters {
+        pid_t tid;
+        int group = -1;                   // leader (cycles) of the hardware group
+        int members[PERF_HARDWARE_EVENTS - 1] = {-1, -1, -1};
+        int clock = -1;                   // task-clock
+        long long runtimeStart = -1;      // schedstat fallback
+    };
+
+    static ThreadCounters openThread(pid_t tid) {
+        ThreadCounters thread;
+        thread.tid = tid;
+        const uint64_t members[PERF_HARDWARE_EVENTS - 1] = {
+            PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+        };
+
+        thread.group = openPerfEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, tid, -1);
+        for (int e = 0; e < PERF_HARDWARE_EVENTS - 1 && thread.group != -1; e++) {
+            thread.members[e] = openPerfEvent(PERF_TYPE_HARDWARE, members[e], tid, thread.group);
+            if (thread.members[e] == -1) {
+                // A partial group would misreport its columns, so drop it whole
+                closeThread(thread);
+            }
+        }
+        thread.clock = openPerfEvent(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK, tid, -1);
+        return thread;
+    }
+
+    static void closeThread(ThreadCounters& thread) {
+        for (int& fd : thread.members) {
+            if (fd != -1) close(fd);
+            fd = -1;
+        }
+        if (thread.group != -1) close(thread.group);
+        if (thread.clock != -1) close(thread.clock);
+        thread.group = -1;
+        thread.clock = -1;
+    }
+
+    std::vector<ThreadCounters> threads_;
+};
+
+#endif // PERF_COUNTERS_H
@@ -1,15 +1,51 @@
 import matplotlib.pyplot as plt
 import pandas as pd
 import numpy as np
+import json
+import os
 
 # Read the CSV file
 df = pd.read_csv('complete_performance_report.csv')
 
+# Per-engine confidence intervals of the median times, when the JSON report
+# written next to the CSV is available
+# (the plain CSV columns describe the first distribution of the sweep)
+intervals = {}
+base = None
+if os.path.exists('complete_performance_report.json'):
+    with open('complete_performance_report.json') as f:
+        results = json.load(f)['results']
+    base = results[0].get('distribution') if results else None
+    for result in results:
+        if result.get('distribution') == base:
+            intervals[(result['engine'], result['size'])] = (result['ci_low'], result['ci_high'])
+
+# Engines as (label, time column, speedup column, marker); engines whose columns
+# are missing from an older report are skipped
+engines = [
+    ('Sequential', 'Sequential Time', None, 'o'),
+    ('Parallel', 'Parallel Time', 'Parallel Speedup', 's'),
+    ('Optimized Parallel', 'Optimized Parallel Time', 'Optimized Speedup', '^'),
+    ('Radix', 'Radix Time', 'Radix Speedup', 'D'),
+    ('Merge Sort', 'Merge Sort Time', 'Merge Sort Speedup', 'v'),
+    ('Sample Sort', 'Sample Sort Time', 'Sample Sort Speedup', 'P'),
+    ('Work-Stealing', 'Work-Stealing Time', 'Work-Stealing Speedup', 'X'),
+    ('Sort Context', 'Sort Context Time', 'Sort Context Speedup', '*'),
+    ('NUMA Merge', 'NUMA Merge Time', 'NUMA Merge Speedup', 'h'),
+]
+engines = [e for e in engines if e[1] in df.columns]
+
 # Plot 1: Execution Time Comparison
 plt.figure(figsize=(12, 6))
-plt.plot(df['Input Size'], df['Sequential Time'], marker='o', label='Sequential')
-plt.plot(df['Input Size'], df['Parallel Time'], marker='s', label='Parallel')
-plt.plot(df['Input Size'], df['Optimized Parallel Time'], marker='^', label='Optimized Parallel')
+for label, time_col, _, marker in engines:
+    engine = time_col[:-len(' Time')]
+    bounds = [intervals.get((engine, size)) for size in df['Input Size']]
+    if intervals and all(b is not None for b in bounds):
+        lower = df[time_col] - [b[0] for b in bounds]
+        upper = [b[1] for b in bounds] - df[time_col]
+        plt.errorbar(df['Input Size'], df[time_col], yerr=[lower, upper], marker=marker, capsize=3, label=label)
+    else:
+        plt.plot(df['Input Size'], df[time_col], marker=marker, label=label)
 plt.xscale('log')
 plt.yscale('log')
 plt.xlabel('Input Size')
@@ -23,8 +59,9 @@ plt.show()
 
 # Plot 2: Speedup Comparison
 plt.figure(figsize=(12, 6))
-plt.plot(df['Input Size'], df['Parallel Speedup'], marker='o', label='Parallel Speedup')
-plt.plot(df['Input Size'], df['Optimized Speedup'], marker='s', label='Optimized Speedup')
+for label, _, speedup_col, marker in engines:
+    if speedup_col is not None:
+        plt.plot(df['Input Size'], df[speedup_col], marker=marker, label=label + ' Speedup')
 plt.axhline(y=1, color='r', linestyle='--', label='Baseline (Sequential)')
 plt.xscale('log')
 plt.xlabel('Input Size')
@@ -37,14 +74,12 @@ plt.savefig('speedup_comparison.png', dpi=300)
 plt.show()
 
 # Plot 3: Relative Performance
-df['Sequential Relative'] = 1  # Baseline
-df['Parallel Relative'] = df['Sequential Time'] / df['Parallel Time']
-df['Optimized Relative'] = df['Sequential Time'] / df['Optimized Parallel Time']
-
+width = 0.8 / len(engines)
 plt.figure(figsize=(12, 6))
-plt.bar(np.arange(len(df)) - 0.2, df['Sequential Relative'], width=0.2, label='Sequential', align='center')
-plt.bar(np.arange(len(df)), df['Parallel Relative'], width=0.2, label='Parallel', align='center')
-plt.bar(np.arange(len(df)) + 0.2, df['Optimized Relative'], width=0.2, label='Optimized Parallel', align='center')
+for k, (label, time_col, _, _) in enumerate(engines):
+    relative = df['Sequential Time'] / df[time_col]
+    offset = (k - (len(engines) - 1) / 2) * width
+    plt.bar(np.arange(len(df)) + offset, relative, width=width, label=label, align='center')
 plt.xlabel('Input Size')
 plt.ylabel('Relative Performance')
 plt.title('Relative Performance Comparison')
@@ -54,3 +89,76 @@ plt.grid(True)
 plt.tight_layout()
 plt.savefig('relative_performance_comparison.png', dpi=300)
 plt.show()
+
+# Plot 4: Speedup per input distribution at the largest input size, from the
+# "<Distribution> <Engine> Speedup" columns
+distributions = []
+for column in df.columns:
+    for _, _, speedup_col, _ in engines:
+        if speedup_col is not None and column.endswith(' ' + speedup_col):
+            prefix = column[:-len(' ' + speedup_col)]
+            if prefix not in distributions:
+                distributions.append(prefix)
+if distributions:
+    parallel = [e for e in engines if e[2] is not None]
+    largest = df.iloc[-1]
+    width = 0.8 / len(parallel)
+    plt.figure(figsize=(12, 6))
+    for k, (label, _, speedup_col, _) in enumerate(parallel):
+        speedups = [largest[speedup_col]] + [largest.get(d + ' ' + speedup_col, np.nan) for d in distributions]
+        offset = (k - (len(parallel) - 1) / 2) * width
+        plt.bar(np.arange(len(speedups)) + offset, speedups, width=width, label=label, align='center')
+    plt.axhline(y=1, color='r', linestyle='--', label='Baseline (Sequential)')
+    plt.xlabel('Input Distribution')
+    plt.ylabel('Speedup')
+    plt.title('Speedup by Input Distribution (input size %d)' % largest['Input Size'])
+    plt.xticks(np.arange(len(distributions) + 1), [(base or 'uniform').title()] + distributions)
+    plt.legend()
+    plt.grid(True)
+    plt.tight_layout()
+    plt.savefig('distribution_speedup_comparison.png', dpi=300)
+    plt.show()
+
+# Plot 5: Strong and weak scaling efficiency, from scaling_report.csv (--scaling)
+if os.path.exists('scaling_report.csv'):
+    scaling = pd.read_csv('scaling_report.csv')
+    fig, axes = plt.subplots(1, 2, figsize=(14, 6))
+    for ax, mode in zip(axes, ['strong', 'weak']):
+        rows = scaling[scaling['Scaling'] == mode]
+        if mode == 'strong':
+            rows = rows[rows['Input Size'] == rows['Input Size'].max()]
+        for label, _, speedup_col, marker in engines:
+            if speedup_col is None:
+                continue
+            for bind, group in rows[rows['Engine'] == label].groupby('Bind'):
+                ax.plot(group['Threads'], group['Scaling Efficiency'], marker=marker, label='%s (%s)' % (label, bind))
+        ax.set_xscale('log', base=2)
+        ax.set_xlabel('Threads')
+        ax.set_ylabel('Scaling Efficiency')
+        ax.set_title('%s Scaling' % mode.title())
+        ax.grid(True)
+    axes[1].legend(fontsize='small')
+    plt.tight_layout()
+    plt.savefig('scaling_efficiency.png', dpi=300)
+    plt.show()
+
+# Plot 6: Cross-node scaling efficiency of the MPI sample sort, from
+# distributed_scaling_report.csv (--distributed), one line per thread count
+if os.path.exists('distributed_scaling_report.csv'):
+    distributed = pd.read_csv('distributed_scaling_report.csv')
+    fig, axes = plt.subplots(1, 2, figsize=(14, 6))
+    for ax, mode in zip(axes, ['strong', 'weak']):
+        rows = distributed[distributed['Scaling'] == mode]
+        if mode == 'strong':
+            rows = rows[rows['Input Size'] == rows['Input Size'].max()]
+        for threads, group in rows.groupby('Threads per Rank'):
+            ax.plot(group['Ranks'], group['Scaling Efficiency'], marker='o', label='%d threads per rank' % threads)
+        ax.set_xscale('log', base=2)
+        ax.set_xlabel('MPI Ranks')
+        ax.set_ylabel('Scaling Efficiency')
+        ax.set_title('Distributed %s Scaling' % mode.title())
+        ax.grid(True)
+    axes[1].legend(fontsize='small')
+    plt.tight_layout()
+    plt.savefig('distributed_scaling_efficiency.png', dpi=300)
+    plt.show()
@@ -0,0 +1,291 @@
+/*
+ * File: radix_sort.h
+ *
+ * Description:
+ * Parallel LSD radix sort and counting sort for int arrays with a bounded key
+ * range, such as the 1..maxValue data produced by the sorters.
+ *
+ * Keys are taken relative to the observed minimum, so only the bits spanned by
+ * max - min are sorted. Each pass builds per-thread histograms over a static
+ * slice of the input, turns them into per-thread bucket offsets with a
+ * prefix-sum, and scatters through small per-bucket write-combining buffers
+ * so that every flush is a full cache line. The digit width is 8 or 11 bits,
+ * whichever needs fewer passes for the observed range.
+ *
+ * Ranges of at most COUNTING_SORT_MAX_RANGE keys skip the radix passes and use
+ * a counting sort instead. tryParallelCountingSort() samples an input for
+ * its number of distinct keys: few keys in a narrow range are counted by
+ * value, and few keys spread over a wide range are counted over the sampled
+ * keys, as long as no element turns out to be missing from the sample.
+ *
+ * The radix passes are templates over the element type and a key extractor
+ * returning an int, so records are sorted stably by their key with the same
+ * code (parallelRadixSortBy); the counting sort only applies to bare ints,
+ * since it rebuilds the values from their counts.
+ */
+
+#ifndef RADIX_SORT_H
+#define RADIX_SORT_H
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <atomic>
+#include <climits>
+#include "omp_compat.h"
+#include "partition.h"  // IdentityKey
+
+const int COUNTING_SORT_MAX_RANGE = 1 << 16;
+const int CARDINALITY_SAMPLE_SIZE = 4096;
+const int RADIX_WC_BUFFER = 16;  // ints per write-combining buffer (one 64-byte line)
+
+struct KeyRange {
+    int minKey;
+    int maxKey;
+};
+
+// Parallel min/max of keyOf over arr[0, N)
+template <typename T, typename KeyOf>
+KeyRange findKeyRangeBy(const T* arr, long long N, KeyOf keyOf) {
+    int minKey = INT_MAX, maxKey = INT_MIN;
+    #pragma omp parallel for reduction(min:minKey) reduction(max:maxKey) schedule(static)
+    for (long long i = 0; i < N; i++) {
+        int key = keyOf(arr[i]);
+        minKey = std::min(minKey, key);
+        maxKey = std::max(maxKey, key);
+    }
+    return {minKey, maxKey};
+}
+
+inline KeyRange findKeyRange(const int* arr, long long N) {
+    return findKeyRangeBy(arr, N, IdentityKey());
+}
+
+// maxKey - minKey without overflow, for ranges spanning the whole int domain
+inline uint64_t keySpan(KeyRange range) {
+    return static_cast<uint64_t>(static_cast<long long>(range.maxKey) - range.minKey);
+}
+
+// Counting sort for keys in [minKey, maxKey]: private per-thread counts, a
+// parallel merge of the counts, then a parallel fill of the output
+inline void parallelCountingSort(int* arr, long long N, int minKey, int maxKey) {
+    const long long range = static_cast<long long>(maxKey) - minKey + 1;
+    const int numThreads = ompMaxThreads();
+    std::vector<long long> counts(static_cast<size_t>(numThreads) * range, 0);
+    std::vector<long long> starts(range + 1, 0);
+
+    #pragma omp parallel num_threads(numThreads)
+    {
+        long long* local = counts.data() + static_cast<size_t>(ompThreadNum()) * range;
+        #pragma omp for schedule(static)
+        for (long long i = 0; i < N; i++) {
+            local[arr[i] - minKey]++;
+        }
+
+        #pragma omp for schedule(static)
+        for (long long k = 0; k < range; k++) {
+            long long total = 0;
+            for (int t = 0; t < numThreads; t++) total += counts[static_cast<size_t>(t) * range + k];
+            starts[k + 1] = total;
+        }
+
+        #pragma omp single
+        for (long long k = 0; k < range; k++) starts[k + 1] += starts[k];
+
+        #pragma omp for schedule(dynamic, 64)
+        for (long long k = 0; k < range; k++) {
+            std::fill(arr + starts[k], arr + starts[k + 1], static_cast<int>(minKey + k));
+        }
+    }
+}
+
+// Counting sort over the sorted distinct keys, for few keys spread over a
+// range too wide to count by value: every element is located in keys by
+// binary search. Returns false (leaving arr untouched) as soon as an element
+// is not one of the keys.
+inline bool parallelCountingSortByKeys(int* arr, long long N, const std::vector<int>& keys) {
+    const long long keyCount = static_cast<long long>(keys.size());
+    const int numThreads = ompMaxThreads();
+    std::vector<long long> counts(static_cast<size_t>(numThreads) * keyCount, 0);
+    std::vector<long long> starts(keyCount + 1, 0);
+    std::atomic<bool> missing{false};
+
+    #pragma omp parallel num_threads(numThreads)
+    {
+        long long* local = counts.data() + static_cast<size_t>(ompThreadNum()) * keyCount;
+        #pragma omp for schedule(static)
+        for (long long i = 0; i < N; i++) {
+            if (missing.load(std::memory_order_relaxed)) continue;
+            auto it = std::lower_bound(keys.begin(), keys.end(), arr[i]);
+            if (it == keys.end() || *it != arr[i]) {
+                missing.store(true, std::memory_order_relaxed);
+                continue;
+            }
+            local[it - keys.begin()]++;
+        }
+    }
+    if (missing.load()) return false;
+
+    for (long long k = 0; k < keyCount; k++) {
+        long long total = 0;
+        for (int t = 0; t < numThreads; t++) total += counts[static_cast<size_t>(t) * keyCount + k];
+        starts[k + 1] = starts[k] + total;
+    }
+
+    #pragma omp parallel for schedule(dynamic, 16) num_threads(numThreads)
+    for (long long k = 0; k < keyCount; k++) {
+        std::fill(arr + starts[k], arr + starts[k + 1], keys[k]);
+    }
+    return true;
+}
+
+// Sorted distinct values among CARDINALITY_SAMPLE_SIZE evenly spaced elements
+inline std::vector<int> sampleDistinctKeys(const int* arr, long long N) {
+    std::vector<int> sample(CARDINALITY_SAMPLE_SIZE);
+    for (int s = 0; s < CARDINALITY_SAMPLE_SIZE; s++) {
+        sample[s] = arr[N / CARDINALITY_SAMPLE_SIZE * s];
+    }
+    std::sort(sample.begin(), sample.end());
+    sample.erase(std::unique(sample.begin(), sample.end()), sample.end());
+    return sample;
+}
+
+// Sorts arr[0, N) with a parallel counting sort if at most half of the
+// sampled keys are distinct, i.e. the input is dominated by repeated keys,
+// and returns false (leaving arr untouched) otherwise. Keys within
+// COUNTING_SORT_MAX_RANGE of each other are counted by value; a wider range
+// is counted over the sampled keys, which fails over to false if the sample
+// missed one. Cheap enough to run before every sort.
+inline bool tryParallelCountingSort(int* arr, long long N) {
+    if (N < 4 * CARDINALITY_SAMPLE_SIZE) return false;
+
+    std::vector<int> keys = sampleDistinctKeys(arr, N);
+    if (static_cast<long long>(keys.size()) > CARDINALITY_SAMPLE_SIZE / 2) return false;
+
+    KeyRange range = findKeyRange(arr, N);
+    if (keySpan(range) < static_cast<uint64_t>(COUNTING_SORT_MAX_RANGE)) {
+        parallelCountingSort(arr, N, range.minKey, range.maxKey);
+        return true;
+    }
+    return parallelCountingSortByKeys(arr, N, keys);
+}
+
+// Picks the digit width (8 or 11 bits) that covers keyBits in fewer passes
+inline int chooseRadixBits(int keyBits) {
+    int bytePasses = (keyBits + 7) / 8;
+    int elevenPasses = (keyBits + 10) / 11;
+    return elevenPasses < bytePasses ? 11 : 8;
+}
+
+// One LSD pass: stable scatter of src into dst by digit (key >> shift) & mask.
+// Must be called by every thread of the enclosing parallel region.
+template <typename T, typename KeyOf>
+void radixScatterPass(const T* src, T* dst, long long N, KeyOf keyOf, int minKey, int shift, int bits, std::vector<long long>& histograms) {
+    // One 64-byte line per write-combining buffer, whatever the element size
+    const int lineElements = static_cast<int>(std::max<size_t>(1, RADIX_WC_BUFFER * sizeof(int) / sizeof(T)));
+    const int numThreads = ompNumThreads();
+    const int buckets = 1 << bits;
+    const uint32_t mask = static_cast<uint32_t>(buckets - 1);
+    const int tid = ompThreadNum();
+    const long long begin = N * tid / numThreads;
+    const long long end = N * (tid + 1) / numThreads;
+    long long* hist = histograms.data() + static_cast<size_t>(tid) * buckets;
+
+    std::fill(hist, hist + buckets, 0);
+    for (long long i = begin; i < end; i++) {
+        uint32_t key = static_cast<uint32_t>(keyOf(src[i])) - static_cast<uint32_t>(minKey);
+        hist[(key >> shift) & mask]++;
+    }
+    #pragma omp barrier
+
+    // Exclusive prefix-sum in (bucket, thread) order gives every thread the
+    // start of its own run inside every bucket
+    #pragma omp single
+    {
+        long long sum = 0;
+        for (int b = 0; b < buckets; b++) {
+            for (int t = 0; t < numThreads; t++) {
+                long long count = histograms[static_cast<size_t>(t) * buckets + b];
+                histograms[static_cast<size_t>(t) * buckets + b] = sum;
+                sum += count;
+            }
+        }
+    }
+
+    std::vector<T> wc(static_cast<size_t>(buckets) * lineElements);
+    std::vector<int> fill(buckets, 0);
+    for (long long i = begin; i < end; i++) {
+        const T& value = src[i];
+        uint32_t key = static_cast<uint32_t>(keyOf(value)) - static_cast<uint32_t>(minKey);
+        uint32_t b = (key >> shift) & mask;
+        T* line = wc.data() + static_cast<size_t>(b) * lineElements;
+        line[fill[b]++] = value;
+        if (fill[b] == lineElements) {
+            std::copy(line, line + lineElements, dst + hist[b]);
+            hist[b] += lineElements;
+            fill[b] = 0;
+        }
+    }
+    for (int b = 0; b < buckets; b++) {
+        const T* line = wc.data() + static_cast<size_t>(b) * lineElements;
+        std::copy(line, line + fill[b], dst + hist[b]);
+    }
+    #pragma omp barrier
+}
+
+// Stable LSD radix passes over arr[0, N) for keys within range
+template <typename T, typename KeyOf>
+void radixSortPasses(T* arr, long long N, KeyOf keyOf, KeyRange range) {
+    uint64_t span = keySpan(range);
+    if (span == 0) return;
+
+    int keyBits = 64 - __builtin_clzll(span);
+    int bits = chooseRadixBits(keyBits);
+    int passes = (keyBits + bits - 1) / bits;
+
+    const int numThreads = ompMaxThreads();
+    std::vector<T> buffer(N);
+    std::vector<long long> histograms(static_cast<size_t>(numThreads) << bits);
+    T* src = arr;
+    T* dst = buffer.data();
+
+    #pragma omp parallel num_threads(numThreads)
+    {
+        T* from = src;
+        T* to = dst;
+        for (int pass = 0; pass < passes; pass++) {
+            radixScatterPass(from, to, N, keyOf, range.minKey, pass * bits, bits, histograms);
+            std::swap(from, to);
+        }
+    }
+
+    if (passes % 2 == 1) {
+        #pragma omp parallel for schedule(static)
+        for (long long i = 0; i < N; i++) arr[i] = buffer[i];
+    }
+}
+
+// Stable LSD radix sort of arr[0, N) by keyOf over the bits spanned by the
+// observed key range
+template <typename T, typename KeyOf>
+void parallelRadixSortBy(T* arr, long long N, KeyOf keyOf) {
+    if (N < 2) return;
+    radixSortPasses(arr, N, keyOf, findKeyRangeBy(arr, N, keyOf));
+}
+
+// Sorts arr[0, N) with LSD radix passes over the bits spanned by the observed
+// key range, falling back to counting sort for small ranges
+inline void parallelRadixSort(int* arr, long long N) {
+    if (N < 2) return;
+
+    KeyRange range = findKeyRange(arr, N);
+    uint64_t span = keySpan(range);
+    if (span < static_cast<uint64_t>(COUNTING_SORT_MAX_RANGE)) {
+        if (span > 0) parallelCountingSort(arr, N, range.minKey, range.maxKey);
+        return;
+    }
+    radixSortPasses(arr, N, IdentityKey(), range);
+}
+
+#endif // RADIX_SORT_H
@@ -0,0 +1,95 @@
+/*
+ * File: random_engine.h
+ *
+ * Description:
+ * Counter-based random number generation for filling large arrays in parallel.
+ * Uses the Philox4x32-10 generator (Salmon et al., "Parallel Random Numbers:
+ * As Easy as 1, 2, 3"): output block b is a pure function of (seed, b), so
+ * each thread computes its own slice without sharing any generator state.
+ * The resulting array is identical for a given seed at any thread count.
+ *
+ * The fill can also return the multiset checksum of what it generated (the
+ * sum of mixValue over the values, as stored in binary_io.h headers), hashed
+ * while each value is still in a register.
+ */
+
+#ifndef RANDOM_ENGINE_H
+#define RANDOM_ENGINE_H
+
+#include <cstdint>
+
+struct PhiloxBlock {
+    uint32_t v[4];
+};
+
+// Philox4x32-10: maps a 128-bit counter and 64-bit key to four random words
+inline PhiloxBlock philox4x32(uint64_t counter, uint64_t key) {
+    const uint32_t M0 = 0xD2511F53u, M1 = 0xCD9E8D57u;
+    const uint32_t W0 = 0x9E3779B9u, W1 = 0xBB67AE85u;
+
+    uint32_t c0 = static_cast<uint32_t>(counter);
+    uint32_t c1 = static_cast<uint32_t>(counter >> 32);
+    uint32_t c2 = 0, c3 = 0;
+    uint32_t k0 = static_cast<uint32_t>(key);
+    uint32_t k1 = static_cast<uint32_t>(key >> 32);
+
+    for (int round = 0; round < 10; round++) {
+        uint64_t p0 = static_cast<uint64_t>(M0) * c0;
+        uint64_t p1 = static_cast<uint64_t>(M1) * c2;
+        uint32_t n0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+        uint32_t n2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+        c1 = static_cast<uint32_t>(p1);
+        c3 = static_cast<uint32_t>(p0);
+        c0 = n0;
+        c2 = n2;
+        k0 += W0;
+        k1 += W1;
+    }
+    return {{c0, c1, c2, c3}};
+}
+
+// Maps a 32-bit random word onto [0, range) with a multiply-shift instead of
+// a modulo (Lemire), which keeps the inner loop free of divisions. range may
+// be as large as 2^32, the size of the whole int domain.
+inline uint32_t reduceToRange(uint32_t word, uint64_t range) {
+    return static_cast<uint32_t>((static_cast<uint64_t>(word) * range) >> 32);
+}
+
+// SplitMix64 finalizer, used to spread every value before it is summed
+inline uint64_t mixValue(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+// Fills numbers[0, N) with elements firstIndex .. firstIndex + N - 1 of the
+// stream of values in [minValue, maxValue] for seed. Element i always comes
+// from lane i % 4 of block i / 4, independent of the thread schedule, so a
+// stream generated piece by piece matches one generated at once. With
+// checksum given, also stores the checksum of numbers[0, N) there.
+inline void fillRandomParallel(int* numbers, int N, int minValue, int maxValue, uint64_t seed, long long firstIndex = 0,
+                               uint64_t* checksum = nullptr) {
+    const uint64_t range = static_cast<uint64_t>(static_cast<long long>(maxValue) - minValue) + 1;
+    const long long endIndex = firstIndex + N;
+    const long long firstBlock = firstIndex / 4;
+    const long long endBlock = (endIndex + 3) / 4;
+    const bool hash = checksum != nullptr;
+    uint64_t sum = 0;
+
+    #pragma omp parallel for reduction(+:sum) schedule(static)
+    for (long long b = firstBlock; b < endBlock; b++) {
+        PhiloxBlock block = philox4x32(static_cast<uint64_t>(b), seed);
+        for (int lane = 0; lane < 4; lane++) {
+            long long i = b * 4 + lane;
+            if (i >= firstIndex && i < endIndex) {
+                int value = static_cast<int>(static_cast<long long>(minValue) + reduceToRange(block.v[lane], range));
+                numbers[i - firstIndex] = value;
+                if (hash) sum += mixValue(static_cast<uint32_t>(value));
+            }
+        }
+    }
+    if (hash) *checksum = sum;
+}
+
+#endif // RANDOM_ENGINE_H
@@ -0,0 +1,134 @@
+/*
+ * File: record_sort.h
+ *
+ * Description:
+ * Sorting of records, such as (key, row id) pairs or a key with a fixed-size
+ * payload, by an int key taken from each record with a key extractor:
+ * - quickSortBy / parallelQuickSortBy: the three-way quicksort engines on
+ *   the templated pivot, partition and insertion steps of partition.h (which
+ *   the int engines use with an identity key). The parallel version
+ *   spawns OpenMP tasks down to the cutoffs in sortTuning().
+ * - parallelRadixSortBy (radix_sort.h): the stable LSD radix engine.
+ * - sortByPackedKeys: for records too large to move around cheaply. Every
+ *   key is packed with its record index into one 64-bit word, the words are
+ *   radix-sorted (8 bytes per element whatever the record size), and the
+ *   permutation is then applied in one gather pass. Each thread fills
+ *   contiguous output blocks of GATHER_BLOCK records and prefetches the
+ *   source records a fixed distance ahead, so a record is copied twice in
+ *   total (gather and copy back) instead of once per partition step.
+ */
+
+#ifndef RECORD_SORT_H
+#define RECORD_SORT_H
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include "omp_compat.h"
+#include "partition.h"
+#include "radix_sort.h"
+#include "sort_tuning.h"
+
+const int GATHER_BLOCK = 4096;
+const int GATHER_PREFETCH_DISTANCE = 16;
+
+// Sequential three-way quicksort of arr[left, right] by keyOf, on the
+// partition steps of partition.h; recurses into the smaller side so the stack
+// depth stays O(log n)
+template <typename T, typename KeyOf>
+void quickSortBy(T* arr, int left, int right, KeyOf keyOf) {
+    const int threshold = sortTuning().insertionSortThreshold;
+    while (right - left >= threshold) {
+        int pivot = keyOf(arr[choosePivotIndexBy(arr, left, right, keyOf)]);
+        PartitionBounds bounds = partitionThreeWayBy(arr, left, right, pivot, keyOf);
+        if (bounds.lt - left < right - bounds.gt) {
+            quickSortBy(arr, left, bounds.lt - 1, keyOf);
+            left = bounds.gt + 1;
+        } else {
+            quickSortBy(arr, bounds.gt + 1, right, keyOf);
+            right = bounds.lt - 1;
+        }
+    }
+    insertionSortBy(arr, left, right, keyOf);
+}
+
+// Task recursion of parallelQuickSortBy; the region's closing barrier joins the tasks
+template <typename T, typename KeyOf>
+void parallelQuickSortTaskBy(T* arr, int left, int right, int depth, KeyOf keyOf) {
+    const SortTuning& tuning = sortTuning();
+    if (right - left < tuning.sequentialThreshold || depth > tuning.maxTaskDepth) {
+        quickSortBy(arr, left, right, keyOf);
+        return;
+    }
+
+    int pivot = keyOf(arr[choosePivotIndexBy(arr, left, right, keyOf)]);
+    PartitionBounds bounds = partitionThreeWayBy(arr, left, right, pivot, keyOf);
+    #pragma omp task
+    parallelQuickSortTaskBy(arr, left, bounds.lt - 1, depth + 1, keyOf);
+    #pragma omp task
+    parallelQuickSortTaskBy(arr, bounds.gt + 1, right, depth + 1, keyOf);
+}
+
+template <typename T, typename KeyOf>
+void parallelQuickSortBy(T* arr, int N, KeyOf keyOf) {
+    #pragma omp parallel
+    {
+        #pragma omp single
+        parallelQuickSortTaskBy(arr, 0, N - 1, 0, keyOf);
+    }
+}
+
+// Key in the high half, biased so that unsigned order matches signed order,
+// and record index in the low half
+inline uint64_t packKeyIndex(int key, uint32_t index) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(key) ^ 0x80000000u) << 32) | index;
+}
+
+inline uint32_t packedIndex(uint64_t packed) {
+    return static_cast<uint32_t>(packed);
+}
+
+// Key extractor for packed words
+struct PackedKey {
+    int operator()(uint64_t packed) const {
+        return static_cast<int>(static_cast<uint32_t>(packed >> 32) ^ 0x80000000u);
+    }
+};
+
+// dst[i] = src[packedIndex(packed[i])], one contiguous output block at a time
+template <typename T>
+void gatherByPackedIndex(const T* src, const uint64_t* packed, T* dst, long long N) {
+    const long long blocks = (N + GATHER_BLOCK - 1) / GATHER_BLOCK;
+    #pragma omp parallel for schedule(static)
+    for (long long b = 0; b < blocks; b++) {
+        const long long begin = b * GATHER_BLOCK;
+        const long long end = std::min(N, begin + GATHER_BLOCK);
+        for (long long i = begin; i < end; i++) {
+            if (i + GATHER_PREFETCH_DISTANCE < end) {
+                __builtin_prefetch(src + packedIndex(packed[i + GATHER_PREFETCH_DISTANCE]));
+            }
+            dst[i] = src[packedIndex(packed[i])];
+        }
+    }
+}
+
+// Stable sort of records[0, N) by keyOf that only moves 64-bit key|index
+// words until the final gather
+template <typename T, typename KeyOf>
+void sortByPackedKeys(T* records, int N, KeyOf keyOf) {
+    if (N < 2) return;
+
+    std::vector<uint64_t> packed(N);
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < N; i++) {
+        packed[i] = packKeyIndex(keyOf(records[i]), static_cast<uint32_t>(i));
+    }
+    parallelRadixSortBy(packed.data(), N, PackedKey());
+
+    std::vector<T> sorted(N);
+    gatherByPackedIndex(records, packed.data(), sorted.data(), N);
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < N; i++) records[i] = sorted[i];
+}
+
+#endif // RECORD_SORT_H
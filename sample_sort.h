@@ -0,0 +1,109 @@
+/*
+ * File: sample_sort.h
+ *
+ * Description:
+ * Parallel sample sort in the style of PSRS (parallel sorting by regular
+ * sampling), for machines with more cores than the capped task recursion of
+ * parallelQuickSort can keep busy:
+ * 1. Draw buckets * oversampling keys at regular positions, sort them, and
+ *    keep every oversampling-th one as the buckets - 1 splitters.
+ * 2. In a single pass, every thread classifies its static slice against the
+ *    splitters, remembering each element's bucket and counting per bucket.
+ * 3. A prefix-sum over the (bucket, thread) counts gives every thread its
+ *    destination in every bucket, and the thread scatters its slice into an
+ *    auxiliary buffer.
+ * 4. Buckets are copied back and sorted independently with std::sort.
+ *
+ * The bucket count is bucketsPerThread * omp_get_max_threads(), so the amount
+ * of parallel work grows with the machine instead of a fixed recursion depth.
+ */
+
+#ifndef SAMPLE_SORT_H
+#define SAMPLE_SORT_H
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include "omp_compat.h"
+#include "scratch_pool.h"
+
+const int SAMPLE_SORT_OVERSAMPLING = 32;
+const int SAMPLE_SORT_BUCKETS_PER_THREAD = 1;
+const int SAMPLE_SORT_SEQUENTIAL_THRESHOLD = 1 << 14;
+
+// Picks buckets - 1 splitters from buckets * oversampling regularly spaced keys
+inline std::vector<int> selectSplitters(const int* arr, long long N, int buckets, int oversampling) {
+    long long sampleSize = std::min<long long>(static_cast<long long>(buckets) * oversampling, N);
+    std::vector<int> sample(sampleSize);
+    for (long long s = 0; s < sampleSize; s++) {
+        sample[s] = arr[(N / sampleSize) * s + (N / sampleSize) / 2];
+    }
+    std::sort(sample.begin(), sample.end());
+
+    std::vector<int> splitters(buckets - 1);
+    for (int b = 1; b < buckets; b++) {
+        splitters[b - 1] = sample[sampleSize * b / buckets];
+    }
+    return splitters;
+}
+
+// Sorts arr[0, N) with the sample sort described above
+inline void parallelSampleSort(int* arr, long long N, int oversampling = SAMPLE_SORT_OVERSAMPLING, int bucketsPerThread = SAMPLE_SORT_BUCKETS_PER_THREAD) {
+    const int maxThreads = ompMaxThreads();
+    const int buckets = std::min(maxThreads * bucketsPerThread, 1 << 16);
+    if (N < SAMPLE_SORT_SEQUENTIAL_THRESHOLD || buckets < 2) {
+        std::sort(arr, arr + N);
+        return;
+    }
+
+    std::vector<int> splitters = selectSplitters(arr, N, buckets, oversampling);
+    std::vector<uint16_t> bucketOf(N);
+    std::vector<long long> offsets(static_cast<size_t>(maxThreads) * buckets, 0);
+    std::vector<long long> bucketStart(buckets + 1, 0);
+    ScratchBuffer buffer(N);
+    int* out = buffer.data();
+
+    #pragma omp parallel
+    {
+        const int numThreads = ompNumThreads();
+        const int tid = ompThreadNum();
+        const long long begin = N * tid / numThreads;
+        const long long end = N * (tid + 1) / numThreads;
+        long long* counts = offsets.data() + static_cast<size_t>(tid) * buckets;
+
+        // Classify once; the bucket index is reused by the scatter
+        for (long long i = begin; i < end; i++) {
+            int b = std::upper_bound(splitters.begin(), splitters.end(), arr[i]) - splitters.begin();
+            bucketOf[i] = static_cast<uint16_t>(b);
+            counts[b]++;
+        }
+        #pragma omp barrier
+
+        #pragma omp single
+        {
+            long long sum = 0;
+            for (int b = 0; b < buckets; b++) {
+                bucketStart[b] = sum;
+                for (int t = 0; t < numThreads; t++) {
+                    long long count = offsets[static_cast<size_t>(t) * buckets + b];
+                    offsets[static_cast<size_t>(t) * buckets + b] = sum;
+                    sum += count;
+                }
+            }
+            bucketStart[buckets] = sum;
+        }
+
+        for (long long i = begin; i < end; i++) {
+            out[counts[bucketOf[i]]++] = arr[i];
+        }
+        #pragma omp barrier
+
+        #pragma omp for schedule(dynamic, 1)
+        for (int b = 0; b < buckets; b++) {
+            std::copy(out + bucketStart[b], out + bucketStart[b + 1], arr + bucketStart[b]);
+            std::sort(arr + bucketStart[b], arr + bucketStart[b + 1]);
+        }
+    }
+}
+
+#endif // SAMPLE_SORT_H
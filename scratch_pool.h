@@ -0,0 +1,88 @@
+/*
+ * File: scratch_pool.h
+ *
+ * Description:
+ * Process-wide pool of reusable int scratch buffers for the sort engines that
+ * need auxiliary memory. Buffers are handed out through ScratchBuffer, which
+ * returns its storage to the pool when it goes out of scope, so repeated
+ * sorts of similar sizes reuse the same (already faulted-in) allocation
+ * instead of allocating and zero-filling a new one every call.
+ */
+
+#ifndef SCRATCH_POOL_H
+#define SCRATCH_POOL_H
+
+#include <vector>
+#include <mutex>
+#include <cstddef>
+
+class ScratchPool {
+public:
+    static ScratchPool& instance() {
+        static ScratchPool pool;
+        return pool;
+    }
+
+    // Returns a buffer holding at least n ints, preferring the smallest
+    // pooled buffer that is already large enough
+    std::vector<int> acquire(size_t n) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t best = free_.size();
+        for (size_t i = 0; i < free_.size(); i++) {
+            if (free_[i].size() >= n && (best == free_.size() || free_[i].size() < free_[best].size())) best = i;
+        }
+        if (best == free_.size()) {
+            // Nothing fits: grow the largest buffer rather than keeping both
+            for (size_t i = 0; i < free_.size(); i++) {
+                if (best == free_.size() || free_[i].size() > free_[best].size()) best = i;
+            }
+        }
+
+        std::vector<int> buffer;
+        if (best != free_.size()) {
+            buffer.swap(free_[best]);
+            free_.erase(free_.begin() + best);
+        }
+        if (buffer.size() < n) buffer.resize(n);
+        return buffer;
+    }
+
+    void release(std::vector<int>&& buffer) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_.push_back(std::move(buffer));
+    }
+
+    // Frees every pooled buffer
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_.clear();
+    }
+
+private:
+    ScratchPool() = default;
+
+    std::mutex mutex_;
+    std::vector<std::vector<int>> free_;
+};
+
+// RAII handle on a pooled scratch buffer of at least n ints
+class ScratchBuffer {
+public:
+    explicit ScratchBuffer(size_t n) : buffer_(ScratchPool::instance().acquire(n)) {}
+
+    ~ScratchBuffer() {
+        ScratchPool::instance().release(std::move(buffer_));
+    }
+
+    ScratchBuffer(const ScratchBuffer&) = delete;
+    ScratchBuffer& operator=(const ScratchBuffer&) = delete;
+
+    int* data() {
+        return buffer_.data();
+    }
+
+private:
+    std::vector<int> buffer_;
+};
+
+#endif // SCRATCH_POOL_H
@@ -0,0 +1,31 @@
+/*
+ * File: seq2par2.h
+ *
+ * Description:
+ * Everything the sorter frontends are made of, for code that embeds the
+ * engines instead of running one of the programs: the sort engines
+ * (sort_engines.h), the CSV and binary dataset I/O (csv_io.h, binary_io.h),
+ * the seeded generators and input distributions (random_engine.h,
+ * input_distributions.h), the out-of-core sort (external_sort.h) and the
+ * output verification (sort_verify.h). The library is header-only: the CMake
+ * target seq2par2 carries its include directory and compile options, and
+ * seq2par2_parallel adds OpenMP.
+ *
+ * The quicksort engines read their cutoffs from sortTuning(). Code that
+ * embeds them loads the per-host profile with
+ * loadTuningProfile(tuningProfilePath(), sortTuning()), as the frontends do
+ * (see sorter_cli.h).
+ */
+
+#ifndef SEQ2PAR2_H
+#define SEQ2PAR2_H
+
+#include "sort_engines.h"
+#include "csv_io.h"
+#include "binary_io.h"
+#include "random_engine.h"
+#include "input_distributions.h"
+#include "external_sort.h"
+#include "sort_verify.h"
+
+#endif // SEQ2PAR2_H
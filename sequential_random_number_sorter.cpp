@@ -12,6 +12,12 @@
  * 3. Sorts the numbers using the C++ standard library's sort function.
  * 4. Writes the sorted numbers to a new CSV file.
  *
+ * It takes the command line of sorter_cli.h: --n N skips the prompt, --engine
+ * picks another engine of sort_engines.h (built without OpenMP, they all run
+ * on one thread), --format binary switches the file format, --seed makes
+ * a run reproducible and --profile loads the quicksort cutoffs (see
+ * sort_tuning.h).
+ *
  * The program uses dynamic memory allocation to handle variable-sized inputs
  * and demonstrates basic file handling in C++.
  */
@@ -21,10 +27,17 @@
 #include <fstream>
 #include <cstdlib>
 #include <ctime>
+#include <cstring>
 #include <algorithm>
+#include "csv_io.h"
+#include "binary_io.h"
+#include "sort_engines.h"
+#include "sorter_cli.h"
 
 const char* INPUT_FILE = "random_numbers.csv";
 const char* OUTPUT_FILE = "sorted_numbers.csv";
+const char* BINARY_INPUT_FILE = "random_numbers.bin";
+const char* BINARY_OUTPUT_FILE = "sorted_numbers.bin";
 
 void generateRandomNumbers(int* numbers, int N, int maxValue) {
     for (int i = 0; i < N; i++) {
@@ -32,66 +45,65 @@ void generateRandomNumbers(int* numbers, int N, int maxValue) {
     }
 }
 
+// Formats per-thread slices with std::to_chars and writes them with pwrite (see csv_io.h)
 void writeToFile(const char* filename, int* numbers, int N) {
-    std::ofstream file(filename);
-    if (!file.is_open()) {
-        std::cerr << "Error opening file: " << filename << std::endl;
-        exit(1);
-    }
-
-    for (int i = 0; i < N - 1; i++) {
-        file << numbers[i] << ",";
-    }
-    file << numbers[N - 1];
-
-    file.close();
+    writeCsvParallel(filename, numbers, N);
 }
 
+// Memory-maps the file and parses it in per-thread chunks (see csv_io.h)
 void readFromFile(const char* filename, int* numbers, int N) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        std::cerr << "Error opening file: " << filename << std::endl;
-        exit(1);
-    }
+    readCsvParallel(filename, numbers, N);
+}
 
-    for (int i = 0; i < N; i++) {
-        if (file.peek() == EOF) break;
-        file >> numbers[i];
-        if (file.peek() == ',') file.ignore();
+int main(int argc, char* argv[]) {
+    // --binary is short for --format binary (see binary_io.h)
+    SorterOptions options;
+    options.engine = SortEngine::Std;
+    for (int a = 1; a < argc; a++) {
+        if (parseSorterOption(argc, argv, a, options)) continue;
+        if (std::strcmp(argv[a], "--binary") == 0) options.binary = true;
     }
 
-    file.close();
-}
+    const bool binaryFormat = options.binary;
+    const char* inputFile = binaryFormat ? BINARY_INPUT_FILE : INPUT_FILE;
+    const char* outputFile = binaryFormat ? BINARY_OUTPUT_FILE : OUTPUT_FILE;
 
-int main() {
-    int N;
-    std::cout << "Enter the number of random numbers to generate: ";
-    std::cin >> N;
+    int N = resolveSorterCount(options);
 
-    srand(time(nullptr));  // Seed the random number generator
+    srand(static_cast<unsigned>(options.seed));  // Seed the random number generator
 
     // Allocate memory on the heap
     int* numbers = new int[N];
 
     // Generate random numbers and write to file
     generateRandomNumbers(numbers, N, 1000);  // Generating numbers between 1 and 1000
-    writeToFile(INPUT_FILE, numbers, N);
 
-    // Read numbers from file
-    readFromFile(INPUT_FILE, numbers, N);
+    if (binaryFormat) {
+        writeBinaryFile(inputFile, numbers, N, false);
 
-    // Sort the numbers
-    std::sort(numbers, numbers + N);
+        // Map the input and sort it in place, without parsing or copying
+        MappedBinaryFile input(inputFile);
+        sortWithEngine(options.engine, input.data(), input.size());
+        writeBinaryFile(outputFile, input.data(), input.size(), true);
+    } else {
+        writeToFile(inputFile, numbers, N);
 
-    // Write sorted numbers to output file
-    writeToFile(OUTPUT_FILE, numbers, N);
+        // Read numbers from file
+        readFromFile(inputFile, numbers, N);
+
+        // Sort the numbers
+        sortWithEngine(options.engine, numbers, N);
+
+        // Write sorted numbers to output file
+        writeToFile(outputFile, numbers, N);
+    }
 
     // Clean up
     delete[] numbers;
 
     std::cout << "Random numbers have been generated, sorted, and written to files." << std::endl;
-    std::cout << "Input file: " << INPUT_FILE << std::endl;
-    std::cout << "Output file: " << OUTPUT_FILE << std::endl;
+    std::cout << "Input file: " << inputFile << std::endl;
+    std::cout << "Output file: " << outputFile << std::endl;
 
     return 0;
 }
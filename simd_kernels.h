@@ -0,0 +1,234 @@
+/*
+ * File: simd_kernels.h
+ *
+ * Description:
+ * Vectorized kernels for the quicksort engines, selected at runtime from the
+ * instruction sets the CPU supports:
+ * - Partition: each vector of keys is compared against the pivot and the
+ *   keys below it are compress-stored to the front of the range in place,
+ *   while the remaining keys are compress-stored into a per-thread scratch
+ *   buffer that is copied back behind them. AVX-512 uses its native
+ *   compress-store; AVX2 emulates it with a permutation lookup table.
+ * - Small sorts: ranges of SIMD_NETWORK_MIN_SIZE..SIMD_NETWORK_MAX_SIZE keys
+ *   are padded to a power of two and sorted with a bitonic network built from
+ *   AVX2 min/max and lane permutes (also used on AVX-512 hosts).
+ *
+ * Without AVX2 (or after setSimdLevel(SimdLevel::Scalar)) the dispatchers fall
+ * back to the scalar kernels in partition.h.
+ */
+
+#ifndef SIMD_KERNELS_H
+#define SIMD_KERNELS_H
+
+#include <vector>
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <immintrin.h>
+#include "partition.h"
+
+const int SIMD_NETWORK_MIN_SIZE = 16;
+const int SIMD_NETWORK_MAX_SIZE = 256;
+const int SIMD_PARTITION_MIN_SIZE = 64;
+
+enum class SimdLevel {
+    Scalar,
+    Avx2,
+    Avx512
+};
+
+inline SimdLevel detectSimdLevel() {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return SimdLevel::Avx512;
+    if (__builtin_cpu_supports("avx2")) return SimdLevel::Avx2;
+    return SimdLevel::Scalar;
+}
+
+// Kernel set in use; defaults to the best one the CPU supports
+inline SimdLevel& activeSimdLevel() {
+    static SimdLevel level = detectSimdLevel();
+    return level;
+}
+
+// Selects a kernel set, clamped to what the CPU supports
+inline void setSimdLevel(SimdLevel level) {
+    activeSimdLevel() = std::min(level, detectSimdLevel());
+}
+
+inline const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::Avx512: return "avx512";
+        case SimdLevel::Avx2: return "avx2";
+        default: return "scalar";
+    }
+}
+
+// Per-thread buffer for the keys that belong right of the split
+inline int* simdPartitionScratch(size_t n) {
+    thread_local std::vector<int> scratch;
+    if (scratch.size() < n + 16) scratch.resize(n + 16);
+    return scratch.data();
+}
+
+// Lane permutations that move the set lanes of an 8-bit mask to the front
+inline const int* avx2CompressTable() {
+    static const std::vector<int> table = [] {
+        std::vector<int> t(256 * 8, 0);
+        for (int mask = 0; mask < 256; mask++) {
+            int k = 0;
+            for (int lane = 0; lane < 8; lane++) {
+                if (mask & (1 << lane)) t[mask * 8 + k++] = lane;
+            }
+        }
+        return t;
+    }();
+    return table.data();
+}
+
+// arr[left, right] -> keys < pivot first; returns the index of the first key
+// >= pivot. AVX2 version.
+__attribute__((target("avx2,popcnt")))
+inline int partitionLessAvx2(int* arr, int left, int right, int pivot) {
+    const int* table = avx2CompressTable();
+    const long long n = static_cast<long long>(right) - left + 1;
+    int* high = simdPartitionScratch(n);
+    const __m256i pv = _mm256_set1_epi32(pivot);
+    int write = left;
+    long long highCount = 0;
+    int i = left;
+
+    // Safe in place: write <= i, so a full store at write only touches keys
+    // that are already loaded
+    for (; i + 7 <= right; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(arr + i));
+        int less = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(pv, v)));
+        int greater = ~less & 0xFF;
+        __m256i lessPerm = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(table + less * 8));
+        __m256i greaterPerm = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(table + greater * 8));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(arr + write), _mm256_permutevar8x32_epi32(v, lessPerm));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(high + highCount), _mm256_permutevar8x32_epi32(v, greaterPerm));
+        write += _mm_popcnt_u32(less);
+        highCount += _mm_popcnt_u32(greater);
+    }
+    for (; i <= right; i++) {
+        if (arr[i] < pivot) arr[write++] = arr[i];
+        else high[highCount++] = arr[i];
+    }
+
+    std::memcpy(arr + write, high, sizeof(int) * highCount);
+    return write;
+}
+
+// AVX-512 version of partitionLessAvx2 using native compress-stores
+__attribute__((target("avx512f")))
+inline int partitionLessAvx512(int* arr, int left, int right, int pivot) {
+    const long long n = static_cast<long long>(right) - left + 1;
+    int* high = simdPartitionScratch(n);
+    const __m512i pv = _mm512_set1_epi32(pivot);
+    int write = left;
+    long long highCount = 0;
+    int i = left;
+
+    for (; i + 15 <= right; i += 16) {
+        __m512i v = _mm512_loadu_si512(arr + i);
+        __mmask16 less = _mm512_cmplt_epi32_mask(v, pv);
+        __mmask16 greater = static_cast<__mmask16>(~less);
+        _mm512_mask_compressstoreu_epi32(arr + write, less, v);
+        _mm512_mask_compressstoreu_epi32(high + highCount, greater, v);
+        write += __builtin_popcount(less);
+        highCount += __builtin_popcount(greater);
+    }
+    for (; i <= right; i++) {
+        if (arr[i] < pivot) arr[write++] = arr[i];
+        else high[highCount++] = arr[i];
+    }
+
+    std::memcpy(arr + write, high, sizeof(int) * highCount);
+    return write;
+}
+
+inline int partitionLessSimd(int* arr, int left, int right, int pivot) {
+    if (activeSimdLevel() == SimdLevel::Avx512) return partitionLessAvx512(arr, left, right, pivot);
+    return partitionLessAvx2(arr, left, right, pivot);
+}
+
+// In-place bitonic sorting network over data[0, n), n a power of two >= 8
+__attribute__((target("avx2")))
+inline void bitonicSortAvx2(int* data, int n) {
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i swap4 = _mm256_setr_epi32(4, 5, 6, 7, 0, 1, 2, 3);
+    const __m256i swap2 = _mm256_setr_epi32(2, 3, 0, 1, 6, 7, 4, 5);
+    const __m256i swap1 = _mm256_setr_epi32(1, 0, 3, 2, 5, 4, 7, 6);
+
+    for (int k = 2; k <= n; k <<= 1) {
+        for (int j = k >> 1; j > 0; j >>= 1) {
+            if (j >= 8) {
+                // Partners are whole vectors apart and share one direction
+                for (int i = 0; i < n; i += 8) {
+                    if (i & j) continue;
+                    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+                    __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + j));
+                    __m256i lo = _mm256_min_epi32(a, b);
+                    __m256i hi = _mm256_max_epi32(a, b);
+                    bool ascending = (i & k) == 0;
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + i), ascending ? lo : hi);
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + i + j), ascending ? hi : lo);
+                }
+            } else {
+                // Partners are lanes of the same vector: compare against a
+                // permuted copy and blend min/max per lane
+                __m256i perm = j == 4 ? swap4 : (j == 2 ? swap2 : swap1);
+                const __m256i jv = _mm256_set1_epi32(j);
+                const __m256i kv = _mm256_set1_epi32(k);
+                for (int i = 0; i < n; i += 8) {
+                    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+                    __m256i p = _mm256_permutevar8x32_epi32(v, perm);
+                    __m256i idx = _mm256_add_epi32(_mm256_set1_epi32(i), lane);
+                    __m256i upper = _mm256_cmpeq_epi32(_mm256_and_si256(idx, jv), jv);
+                    __m256i descending = _mm256_cmpeq_epi32(_mm256_and_si256(idx, kv), kv);
+                    __m256i takeMax = _mm256_xor_si256(upper, descending);
+                    v = _mm256_blendv_epi8(_mm256_min_epi32(v, p), _mm256_max_epi32(v, p), takeMax);
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + i), v);
+                }
+            }
+        }
+    }
+}
+
+// Sorts arr[left, right] with the bitonic network if the range size and the
+// CPU allow it; returns false (leaving the range untouched) otherwise
+inline bool simdSortSmall(int* arr, int left, int right) {
+    int n = right - left + 1;
+    if (activeSimdLevel() == SimdLevel::Scalar || n < SIMD_NETWORK_MIN_SIZE || n > SIMD_NETWORK_MAX_SIZE) {
+        return false;
+    }
+
+    int padded = 8;
+    while (padded < n) padded <<= 1;
+    alignas(32) int buffer[SIMD_NETWORK_MAX_SIZE];
+    std::memcpy(buffer, arr + left, sizeof(int) * n);
+    std::fill(buffer + n, buffer + padded, INT_MAX);
+    bitonicSortAvx2(buffer, padded);
+    std::memcpy(arr + left, buffer, sizeof(int) * n);
+    return true;
+}
+
+// Drop-in replacement for partitionRange that uses the vectorized partition
+// when available. The second sweep (keys equal to the pivot) only runs when
+// nothing is below the pivot, which still guarantees progress.
+inline PartitionBounds simdPartitionRange(int* arr, int left, int right) {
+    if (activeSimdLevel() == SimdLevel::Scalar || right - left + 1 < SIMD_PARTITION_MIN_SIZE) {
+        return partitionRange(arr, left, right);
+    }
+
+    int pivot = choosePivot(arr, left, right);
+    int lt = partitionLessSimd(arr, left, right, pivot);
+    if (lt > left) return {lt, lt - 1};
+
+    // Everything is >= pivot: gather the pivot's copies (x < pivot + 1)
+    if (pivot == INT_MAX) return {lt, right};
+    int gt = partitionLessSimd(arr, lt, right, pivot + 1) - 1;
+    return {lt, gt};
+}
+
+#endif // SIMD_KERNELS_H
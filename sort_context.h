@@ -0,0 +1,89 @@
+/*
+ * File: sort_context.h
+ *
+ * Description:
+ * Reusable sorting context for callers that sort many small and medium
+ * arrays. A SortContext owns a WorkStealingPool whose workers are created
+ * once, pinned to cores and parked between calls (after a short spin, see
+ * work_stealing.h), plus the scratch memory the sort needs, so a call to
+ * sort() neither opens an OpenMP parallel region nor allocates a scratch
+ * buffer once the context has seen an input of that size.
+ *
+ * Arrays below SORT_CONTEXT_PARALLEL_THRESHOLD are sorted on the calling
+ * thread with blockQuickSort. Larger ones go through the multiway mergesort
+ * of merge_sort.h, run as three passes on the pool:
+ * 1. Every chunk is copied into the scratch buffer and sorted there.
+ * 2. The start of every output slice is located in the sorted chunks.
+ * 3. Every output slice is merged from the sorted chunks straight back into
+ *    the caller's array, so no final copy is needed.
+ *
+ * A context is meant to be used by one thread at a time.
+ */
+
+#ifndef SORT_CONTEXT_H
+#define SORT_CONTEXT_H
+
+#include <vector>
+#include <algorithm>
+#include <span>
+#include "work_stealing.h"
+#include "merge_sort.h"
+#include "block_quicksort.h"
+
+// Below this size the pool is not worth waking up
+const long long SORT_CONTEXT_PARALLEL_THRESHOLD = 1 << 15;
+
+class SortContext {
+public:
+    // scratchCapacity preallocates (and faults in) room for arrays of that
+    // size; the buffer still grows if a larger array comes along
+    explicit SortContext(int numWorkers, long long scratchCapacity = 0, bool pinWorkers = true)
+        : pool_(numWorkers, pinWorkers), runs_(pool_.size()), cuts_(pool_.size() + 1) {
+        reserve(scratchCapacity);
+    }
+
+    SortContext(const SortContext&) = delete;
+    SortContext& operator=(const SortContext&) = delete;
+
+    int workers() const { return pool_.size(); }
+
+    void reserve(long long capacity) {
+        if (capacity > static_cast<long long>(scratch_.size())) scratch_.resize(capacity);
+    }
+
+    void sort(std::span<int> data) {
+        const long long N = static_cast<long long>(data.size());
+        if (N < 2) return;
+        if (N < SORT_CONTEXT_PARALLEL_THRESHOLD || pool_.size() == 1) {
+            blockQuickSort(data.data(), 0, static_cast<int>(N - 1));
+            return;
+        }
+
+        reserve(N);
+        int* arr = data.data();
+        int* sorted = scratch_.data();
+        const int chunks = pool_.size();
+        for (int c = 0; c < chunks; c++) runs_[c] = {N * c / chunks, N * (c + 1) / chunks};
+
+        parallelFor(pool_, chunks, [&](int c) {
+            std::copy(arr + runs_[c].begin, arr + runs_[c].end, sorted + runs_[c].begin);
+            blockQuickSort(sorted, static_cast<int>(runs_[c].begin), static_cast<int>(runs_[c].end - 1));
+        });
+
+        parallelFor(pool_, chunks + 1, [&](int c) {
+            selectMultiwaySplit(sorted, runs_, N * c / chunks, cuts_[c]);
+        });
+
+        parallelFor(pool_, chunks, [&](int c) {
+            mergeRuns(sorted, cuts_[c], cuts_[c + 1], arr + N * c / chunks);
+        });
+    }
+
+private:
+    WorkStealingPool pool_;
+    std::vector<int> scratch_;
+    std::vector<SortedRun> runs_;
+    std::vector<std::vector<long long>> cuts_;  // cuts_[c]: split at output slice c's start
+};
+
+#endif // SORT_CONTEXT_H
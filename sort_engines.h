@@ -0,0 +1,259 @@
+/*
+ * File: sort_engines.h
+ *
+ * Description:
+ * The in-memory sort engines behind one name each, for the sorter frontends
+ * and for code that embeds them:
+ * - the sequential quicksort and the two OpenMP task quicksorts (formerly
+ *   private to complete_performance_analysis), whose cutoffs and leaf engine
+ *   come from sortTuning() (see sort_tuning.h)
+ * - the radix, multiway merge, sample and NUMA sort-then-merge engines of
+ *   their own headers
+ * - "auto", which takes the parallel counting sort when sampling finds only a
+ *   few distinct keys and the task quicksort otherwise
+ * sortWithEngine() runs any of them on an int array. Everything compiles
+ * without OpenMP too, in which case the parallel engines run on the calling
+ * thread.
+ */
+
+#ifndef SORT_ENGINES_H
+#define SORT_ENGINES_H
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include "partition.h"
+#include "simd_kernels.h"
+#include "block_quicksort.h"
+#include "sort_tuning.h"
+#include "task_trace.h"
+#include "radix_sort.h"
+#include "merge_sort.h"
+#include "sample_sort.h"
+#include "numa_buffer.h"
+
+// Sequential QuickSort implementation (median-of-three pivots, see partition.h).
+// Recurses into the smaller side and loops on the larger one, so the stack
+// depth stays O(log n) even on skewed inputs. Small leaves use the SIMD
+// sorting network when available and insertion sort otherwise; partitions use
+// the vectorized kernel when available (see simd_kernels.h).
+inline void sequentialQuickSort(int* arr, int left, int right) {
+    while (left < right) {
+        if (simdSortSmall(arr, left, right)) {
+            return;
+        }
+        if (right - left < sortTuning().insertionSortThreshold) {
+            insertionSort(arr, left, right);
+            return;
+        }
+
+        PartitionBounds bounds = simdPartitionRange(arr, left, right);
+
+        if (bounds.lt - left < right - bounds.gt) {
+            sequentialQuickSort(arr, left, bounds.lt - 1);
+            left = bounds.gt + 1;
+        } else {
+            sequentialQuickSort(arr, bounds.gt + 1, right);
+            right = bounds.lt - 1;
+        }
+    }
+}
+
+// Sorts a leaf of the parallel recursion with the configured sequential engine
+inline void sortLeaf(int* arr, int left, int right) {
+    switch (sortTuning().leafEngine) {
+        case LeafEngine::BlockQuickSort:
+            blockQuickSort(arr, left, right);
+            break;
+        case LeafEngine::StdSort:
+            if (left < right) std::sort(arr + left, arr + right + 1);
+            break;
+        default:
+            sequentialQuickSort(arr, left, right);
+    }
+}
+
+// Optimized Parallel QuickSort implementation (traced with --trace, see task_trace.h)
+inline void optimizedParallelQuickSort(int* arr, int left, int right, int depth = 0) {
+    if (right - left <= sortTuning().smallArrayThreshold) {
+        TraceScope trace(TraceKind::Leaf, left, right, depth);
+        sortLeaf(arr, left, right);
+    } else if (left < right) {
+        PartitionBounds bounds;
+        {
+            TraceScope trace(TraceKind::Partition, left, right, depth);
+            bounds = simdPartitionRange(arr, left, right);
+        }
+
+        #pragma omp task
+        optimizedParallelQuickSort(arr, left, bounds.lt - 1, depth + 1);
+
+        #pragma omp task
+        optimizedParallelQuickSort(arr, bounds.gt + 1, right, depth + 1);
+
+        TraceScope trace(TraceKind::Taskwait, left, right, depth);
+        #pragma omp taskwait  // Ensure that tasks complete before proceeding
+    }
+}
+
+// Parallel QuickSort implementation with improved synchronization
+inline void parallelQuickSort(int* arr, int low, int high, int depth = 0) {
+    const int maxDepth = sortTuning().maxTaskDepth;
+    if (high - low < sortTuning().sequentialThreshold || depth > maxDepth) {
+        TraceScope trace(TraceKind::Leaf, low, high, depth);
+        sortLeaf(arr, low, high);
+        return;
+    }
+
+    PartitionBounds bounds;
+    {
+        TraceScope trace(TraceKind::Partition, low, high, depth);
+        bounds = simdPartitionRange(arr, low, high);
+    }
+
+    #pragma omp task if(depth <= maxDepth)
+    parallelQuickSort(arr, low, bounds.lt - 1, depth + 1);
+
+    #pragma omp task if(depth <= maxDepth)
+    parallelQuickSort(arr, bounds.gt + 1, high, depth + 1);
+
+    TraceScope trace(TraceKind::Taskwait, low, high, depth);
+    #pragma omp taskwait  // Ensure that tasks complete before proceeding
+}
+
+// Sorts arr[0, N) with parallelQuickSort tasks. Large inputs are first split
+// with team-wide parallel partitions (see partition.h); tasks are only
+// spawned for the resulting pieces.
+inline void parallelTaskQuickSort(int* arr, int N) {
+    std::vector<IndexRange> pieces;
+    {
+        TraceScope trace(TraceKind::Split, 0, N - 1);
+        pieces = splitLargeRanges(arr, 0, N - 1);
+    }
+
+    #pragma omp parallel
+    {
+        #pragma omp single nowait
+        for (const IndexRange& piece : pieces) {
+            #pragma omp task
+            parallelQuickSort(arr, piece.left, piece.right, piece.depth);
+        }
+    }
+}
+
+// Same with optimizedParallelQuickSort tasks
+inline void optimizedTaskQuickSort(int* arr, int N) {
+    std::vector<IndexRange> pieces;
+    {
+        TraceScope trace(TraceKind::Split, 0, N - 1);
+        pieces = splitLargeRanges(arr, 0, N - 1);
+    }
+
+    #pragma omp parallel
+    {
+        #pragma omp single
+        for (const IndexRange& piece : pieces) {
+            #pragma omp task
+            optimizedParallelQuickSort(arr, piece.left, piece.right);
+        }
+    }
+}
+
+enum class SortEngine {
+    Auto,                // counting sort for few distinct keys, parallelTaskQuickSort otherwise
+    Std,                 // std::sort
+    QuickSort,           // sequentialQuickSort
+    ParallelQuickSort,   // parallelTaskQuickSort
+    OptimizedQuickSort,  // optimizedTaskQuickSort
+    Radix,               // parallelRadixSort, see radix_sort.h
+    MergeSort,           // parallelMultiwayMergeSort, see merge_sort.h
+    SampleSort,          // parallelSampleSort, see sample_sort.h
+    NumaMerge            // numaSortThenMerge, see numa_buffer.h
+};
+
+const SortEngine ALL_SORT_ENGINES[] = {
+    SortEngine::Auto, SortEngine::Std, SortEngine::QuickSort, SortEngine::ParallelQuickSort,
+    SortEngine::OptimizedQuickSort, SortEngine::Radix, SortEngine::MergeSort, SortEngine::SampleSort,
+    SortEngine::NumaMerge
+};
+
+inline const char* sortEngineName(SortEngine engine) {
+    switch (engine) {
+        case SortEngine::Std: return "std";
+        case SortEngine::QuickSort: return "quicksort";
+        case SortEngine::ParallelQuickSort: return "parallel-quicksort";
+        case SortEngine::OptimizedQuickSort: return "optimized-quicksort";
+        case SortEngine::Radix: return "radix";
+        case SortEngine::MergeSort: return "merge";
+        case SortEngine::SampleSort: return "sample";
+        case SortEngine::NumaMerge: return "numa-merge";
+        default: return "auto";
+    }
+}
+
+// Returns false for an unknown name
+inline bool parseSortEngine(const char* name, SortEngine& engine) {
+    for (SortEngine candidate : ALL_SORT_ENGINES) {
+        if (std::strcmp(name, sortEngineName(candidate)) == 0) {
+            engine = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Sorts data[0, N) with engine. The quicksorts index with int, so they take
+// at most INT_MAX values. The numa-merge engine uses scratch when given (at
+// least N ints, ideally a NumaBuffer placed like data) and otherwise
+// allocates and first-touches one on every call.
+inline void sortWithEngine(SortEngine engine, int* data, long long N, int* scratch = nullptr) {
+    if (N < 2) return;
+    bool intIndexed = engine == SortEngine::Auto || engine == SortEngine::QuickSort ||
+                      engine == SortEngine::ParallelQuickSort || engine == SortEngine::OptimizedQuickSort;
+    if (intIndexed && N > INT_MAX) {
+        std::cerr << "Error: the " << sortEngineName(engine) << " engine sorts at most " << INT_MAX << " values" << std::endl;
+        exit(1);
+    }
+
+    switch (engine) {
+        case SortEngine::Auto:
+            if (tryParallelCountingSort(data, N)) break;
+            parallelTaskQuickSort(data, static_cast<int>(N));
+            break;
+        case SortEngine::Std:
+            std::sort(data, data + N);
+            break;
+        case SortEngine::QuickSort:
+            sequentialQuickSort(data, 0, static_cast<int>(N) - 1);
+            break;
+        case SortEngine::ParallelQuickSort:
+            parallelTaskQuickSort(data, static_cast<int>(N));
+            break;
+        case SortEngine::OptimizedQuickSort:
+            optimizedTaskQuickSort(data, static_cast<int>(N));
+            break;
+        case SortEngine::Radix:
+            parallelRadixSort(data, N);
+            break;
+        case SortEngine::MergeSort:
+            parallelMultiwayMergeSort(data, N);
+            break;
+        case SortEngine::SampleSort:
+            parallelSampleSort(data, N);
+            break;
+        case SortEngine::NumaMerge: {
+            if (scratch != nullptr) {
+                numaSortThenMerge(data, N, scratch);
+                break;
+            }
+            NumaBuffer<int> buffer(N);
+            numaSortThenMerge(data, N, buffer.data());
+            break;
+        }
+    }
+}
+
+#endif // SORT_ENGINES_H
@@ -0,0 +1,105 @@
+/*
+ * File: sort_tuning.h
+ *
+ * Description:
+ * Runtime cutoffs for the quicksort engines, replacing the former hard-coded
+ * SMALL_ARRAY_THRESHOLD / SEQUENTIAL_THRESHOLD constants and the depth > 3 task
+ * cap, plus the engine the parallel quicksorts use for their sequential
+ * leaves. The active values live in sortTuning() and can be saved to and
+ * loaded from a per-host profile file (sort_profile_<hostname>.cfg) holding
+ * one "key=value" pair per line. complete_performance_analysis --tune
+ * measures the values on the current machine and writes that file.
+ */
+
+#ifndef SORT_TUNING_H
+#define SORT_TUNING_H
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+// Sequential engine used below the parallel cutoffs
+enum class LeafEngine {
+    QuickSort,       // sequentialQuickSort (SIMD kernels when available)
+    BlockQuickSort,  // branchless block introsort, see block_quicksort.h
+    StdSort
+};
+
+inline const char* leafEngineName(LeafEngine engine) {
+    switch (engine) {
+        case LeafEngine::BlockQuickSort: return "block";
+        case LeafEngine::StdSort: return "std";
+        default: return "quicksort";
+    }
+}
+
+inline LeafEngine parseLeafEngine(const char* name) {
+    if (std::strcmp(name, "block") == 0) return LeafEngine::BlockQuickSort;
+    if (std::strcmp(name, "std") == 0) return LeafEngine::StdSort;
+    return LeafEngine::QuickSort;
+}
+
+struct SortTuning {
+    int smallArrayThreshold = 1000;   // optimizedParallelQuickSort: sequential below this size
+    int sequentialThreshold = 1000;   // parallelQuickSort: sequential below this size
+    int maxTaskDepth = 3;             // parallelQuickSort: sequential beyond this task depth
+    int insertionSortThreshold = 16;  // sequentialQuickSort: insertion sort at or below this size
+    LeafEngine leafEngine = LeafEngine::QuickSort;
+};
+
+// Process-wide tuning used by the engines
+inline SortTuning& sortTuning() {
+    static SortTuning tuning;
+    return tuning;
+}
+
+// Default profile location for this machine
+inline std::string tuningProfilePath() {
+    char host[256] = "localhost";
+    gethostname(host, sizeof(host) - 1);
+    host[sizeof(host) - 1] = '\0';
+    return std::string("sort_profile_") + host + ".cfg";
+}
+
+// Loads tuning from path; unknown keys are ignored and missing keys keep their
+// current value. Returns false if the file cannot be opened.
+inline bool loadTuningProfile(const std::string& path, SortTuning& tuning) {
+    std::ifstream file(path);
+    if (!file.is_open()) return false;
+
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t eq = line.find('=');
+        if (line.empty() || line[0] == '#' || eq == std::string::npos) continue;
+        std::string key = line.substr(0, eq);
+        const char* text = line.c_str() + eq + 1;
+        int value = std::atoi(text);
+
+        if (key == "small_array_threshold") tuning.smallArrayThreshold = value;
+        else if (key == "sequential_threshold") tuning.sequentialThreshold = value;
+        else if (key == "max_task_depth") tuning.maxTaskDepth = value;
+        else if (key == "insertion_sort_threshold") tuning.insertionSortThreshold = value;
+        else if (key == "leaf_engine") tuning.leafEngine = parseLeafEngine(text);
+    }
+    return true;
+}
+
+inline void saveTuningProfile(const std::string& path, const SortTuning& tuning) {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Error opening file: " << path << std::endl;
+        exit(1);
+    }
+
+    file << "# Sort engine cutoffs measured by complete_performance_analysis --tune" << std::endl;
+    file << "small_array_threshold=" << tuning.smallArrayThreshold << std::endl;
+    file << "sequential_threshold=" << tuning.sequentialThreshold << std::endl;
+    file << "max_task_depth=" << tuning.maxTaskDepth << std::endl;
+    file << "insertion_sort_threshold=" << tuning.insertionSortThreshold << std::endl;
+    file << "leaf_engine=" << leafEngineName(tuning.leafEngine) << std::endl;
+}
+
+#endif // SORT_TUNING_H
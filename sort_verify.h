@@ -0,0 +1,97 @@
+/*
+ * File: sort_verify.h
+ *
+ * Description:
+ * Checks that a sort produced a sorted permutation of its input, without
+ * keeping a copy of the input or of a reference sort. Two properties are
+ * checked in one parallel pass over the output:
+ * - order: every thread scans its static slice for a descent, and the first
+ *   descent overall is the smallest index any thread found
+ * - content: the order-independent multiset checksum of binary_io.h, which
+ *   must match the checksum taken of the input while it was generated or
+ *   parsed
+ * A SortVerifier can be fed the output in consecutive pieces, so a sorted
+ * file can be verified block by block in memory of one block.
+ */
+
+#ifndef SORT_VERIFY_H
+#define SORT_VERIFY_H
+
+#include <iostream>
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include "binary_io.h"
+
+class SortVerifier {
+public:
+    // Checks values[0, n) as the continuation of the values added so far
+    void add(const int* values, long long n) {
+        if (n <= 0) return;
+        const long long offset = count_;
+        const int previous = last_;
+        uint64_t sum = 0;
+        long long descent = LLONG_MAX;
+
+        #pragma omp parallel for reduction(+:sum) reduction(min:descent) schedule(static)
+        for (long long i = 0; i < n; i++) {
+            sum += mixValue(static_cast<uint32_t>(values[i]));
+            int before = i == 0 ? previous : values[i - 1];
+            if ((i > 0 || offset > 0) && before > values[i]) descent = std::min(descent, offset + i);
+        }
+
+        checksum_ += sum;
+        if (firstUnsorted_ < 0 && descent != LLONG_MAX) firstUnsorted_ = descent;
+        count_ += n;
+        last_ = values[n - 1];
+    }
+
+    bool sorted() const { return firstUnsorted_ < 0; }
+
+    // Index i of the first value smaller than value i - 1, -1 when sorted
+    long long firstUnsorted() const { return firstUnsorted_; }
+
+    uint64_t checksum() const { return checksum_; }
+    long long count() const { return count_; }
+
+private:
+    long long count_ = 0;
+    long long firstUnsorted_ = -1;
+    uint64_t checksum_ = 0;
+    int last_ = INT_MIN;
+};
+
+inline SortVerifier verifySorted(const int* values, long long n) {
+    SortVerifier verifier;
+    verifier.add(values, n);
+    return verifier;
+}
+
+// Prints the outcome of a verification and returns whether it passed.
+// firstUnsorted is -1 for sorted output. Without expectedChecksum (as for a
+// rank range, which is not a permutation of the input) only count and order
+// are checked.
+inline bool reportVerification(long long firstUnsorted, long long count, uint64_t checksum,
+                               long long expectedCount, const uint64_t* expectedChecksum) {
+    bool countMatches = count == expectedCount;
+    bool checksumMatches = expectedChecksum == nullptr || checksum == *expectedChecksum;
+    if (firstUnsorted < 0 && countMatches && checksumMatches) {
+        std::cout << "Verification: passed (" << count << " values sorted"
+                  << (expectedChecksum != nullptr ? ", checksum matches the input" : "") << ")" << std::endl;
+        return true;
+    }
+
+    std::cerr << "Error: verification failed";
+    if (firstUnsorted >= 0) std::cerr << "; value " << firstUnsorted << " is out of order";
+    if (!countMatches) std::cerr << "; " << count << " values instead of " << expectedCount;
+    if (!checksumMatches) std::cerr << "; checksum differs from the input";
+    std::cerr << std::endl;
+    return false;
+}
+
+inline bool reportVerification(const SortVerifier& verifier, long long expectedCount, const uint64_t* expectedChecksum) {
+    return reportVerification(verifier.firstUnsorted(), verifier.count(), verifier.checksum(),
+                              expectedCount, expectedChecksum);
+}
+
+#endif // SORT_VERIFY_H
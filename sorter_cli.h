@@ -0,0 +1,112 @@
+/*
+ * File: sorter_cli.h
+ *
+ * Description:
+ * Command line shared by the sorter frontends, so that they can run without
+ * a prompt from scripts:
+ *   --n N                number of values; asked for when absent and stdin
+ *                        is a terminal, required otherwise
+ *   --engine NAME        in-memory sort engine, see sort_engines.h
+ *   --format csv|binary  dataset file format, see csv_io.h and binary_io.h
+ *   --threads T          OpenMP threads (default: OMP_NUM_THREADS or all cores)
+ *   --seed S             seed of the generated values (default: the time)
+ *   --profile PATH       engine cutoffs to load (see sort_tuning.h); by
+ *                        default the per-host profile written by
+ *                        complete_performance_analysis --tune, if there is one
+ * A frontend passes each argument to parseSorterOption first and handles the
+ * ones it leaves alone itself.
+ */
+
+#ifndef SORTER_CLI_H
+#define SORTER_CLI_H
+
+#include <iostream>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <climits>
+#include <ctime>
+#include <string>
+#include <unistd.h>
+#include "omp_compat.h"
+#include "sort_tuning.h"
+#include "sort_engines.h"
+
+struct SorterOptions {
+    long long n = -1;  // -1: ask on stdin
+    SortEngine engine = SortEngine::Auto;
+    bool binary = false;
+    int threads = 0;   // 0: the OpenMP default
+    uint64_t seed = static_cast<uint64_t>(time(nullptr));
+    std::string profile;  // empty: tuningProfilePath(), when it exists
+};
+
+// Consumes argv[a], and the value after it, if it is one of the flags above;
+// exits on an invalid value
+inline bool parseSorterOption(int argc, char* argv[], int& a, SorterOptions& options) {
+    const char* flag = argv[a];
+    if (a + 1 >= argc) return false;
+    const char* value = argv[a + 1];
+
+    if (std::strcmp(flag, "--n") == 0) {
+        char* end;
+        options.n = std::strtoll(value, &end, 10);
+        if (end == value || *end != '\0' || options.n < 0 || options.n > INT_MAX) {
+            std::cerr << "Error: --n must be an integer between 0 and " << INT_MAX << std::endl;
+            exit(1);
+        }
+    } else if (std::strcmp(flag, "--engine") == 0) {
+        if (!parseSortEngine(value, options.engine)) {
+            std::cerr << "Error: unknown sort engine: " << value << " (one of";
+            for (SortEngine engine : ALL_SORT_ENGINES) std::cerr << " " << sortEngineName(engine);
+            std::cerr << ")" << std::endl;
+            exit(1);
+        }
+    } else if (std::strcmp(flag, "--format") == 0) {
+        if (std::strcmp(value, "csv") != 0 && std::strcmp(value, "binary") != 0) {
+            std::cerr << "Error: unknown file format: " << value << " (csv or binary)" << std::endl;
+            exit(1);
+        }
+        options.binary = std::strcmp(value, "binary") == 0;
+    } else if (std::strcmp(flag, "--threads") == 0) {
+        options.threads = std::max(1, std::atoi(value));
+    } else if (std::strcmp(flag, "--seed") == 0) {
+        options.seed = std::strtoull(value, nullptr, 10);
+    } else if (std::strcmp(flag, "--profile") == 0) {
+        options.profile = value;
+    } else {
+        return false;
+    }
+    a++;
+    return true;
+}
+
+// Applies --threads and --profile and returns --n, or without it the count
+// typed at the prompt
+inline int resolveSorterCount(const SorterOptions& options) {
+    if (options.threads > 0) ompSetNumThreads(options.threads);
+
+    const std::string profile = options.profile.empty() ? tuningProfilePath() : options.profile;
+    if (loadTuningProfile(profile, sortTuning())) {
+        std::cout << "Loaded tuning profile " << profile << std::endl;
+    } else if (!options.profile.empty()) {
+        std::cerr << "Error opening file: " << profile << std::endl;
+        exit(1);
+    }
+    if (options.n >= 0) return static_cast<int>(options.n);
+
+    if (!isatty(STDIN_FILENO)) {
+        std::cerr << "Error: --n is required when stdin is not a terminal" << std::endl;
+        exit(1);
+    }
+    int N;
+    std::cout << "Enter the number of random numbers to generate: ";
+    if (!(std::cin >> N) || N < 0) {
+        std::cerr << "Error: the number of values must be a non-negative integer" << std::endl;
+        exit(1);
+    }
+    return N;
+}
+
+#endif // SORTER_CLI_H
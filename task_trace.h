@@ -0,0 +1,177 @@
+/*
+ * File: task_trace.h
+ *
+ * Description:
+ * Low-overhead tracing of the task-parallel sorts. Instrumented code opens a
+ * TraceScope around each phase (partition, leaf sort, taskwait, ...); when
+ * tracing is off the scope costs one predictable branch. When it is on, the
+ * scope's begin and end timestamps go into the calling OpenMP thread's own
+ * ring buffer: each ring has a single writer, so recording takes no locks and
+ * no atomics, and a full ring overwrites its oldest events. The rings are
+ * only read by writeChromeTrace, after the traced parallel regions have
+ * ended.
+ *
+ * The output is Chrome trace event JSON ("X" complete events, one track per
+ * thread), which chrome://tracing and ui.perfetto.dev open directly. Every
+ * event carries the subrange [left, right] and recursion depth it worked on.
+ * Tasks a thread runs while it waits in a taskwait nest under that taskwait's
+ * span; the gaps between them are the time it actually stalled.
+ */
+
+#ifndef TASK_TRACE_H
+#define TASK_TRACE_H
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include "omp_compat.h"
+
+// Events kept per thread; older ones are overwritten
+const int TRACE_RING_EVENTS = 1 << 16;
+
+enum class TraceKind : uint8_t {
+    Sort,       // one whole engine call, named after the engine
+    Split,      // team-wide partitioning of the top levels (partition.h)
+    Partition,  // one task's partition step
+    Leaf,       // sequential sort of a leaf range
+    Taskwait    // time a task spent waiting for its children
+};
+
+inline const char* traceKindName(TraceKind kind) {
+    switch (kind) {
+        case TraceKind::Sort: return "sort";
+        case TraceKind::Split: return "split";
+        case TraceKind::Partition: return "partition";
+        case TraceKind::Leaf: return "leaf";
+        default: return "taskwait";
+    }
+}
+
+struct TraceEvent {
+    uint64_t begin;  // nanoseconds since the trace was enabled
+    uint64_t end;
+    int left;
+    int right;
+    int depth;
+    TraceKind kind;
+    const char* name;  // engine name for Sort events, nullptr otherwise
+};
+
+// One thread's ring, aligned so that neighbouring rings never share a line
+struct alignas(64) TraceRing {
+    std::vector<TraceEvent> events;
+    uint64_t recorded = 0;  // total events ever recorded; the ring holds the last ones
+};
+
+struct TraceState {
+    bool enabled = false;
+    std::chrono::steady_clock::time_point origin;
+    std::vector<TraceRing> rings;
+};
+
+inline TraceState& traceState() {
+    static TraceState state;
+    return state;
+}
+
+inline bool traceEnabled() {
+    return traceState().enabled;
+}
+
+// Allocates one ring per OpenMP thread and starts the clock; call outside of
+// any parallel region
+inline void enableTracing() {
+    TraceState& state = traceState();
+    state.rings = std::vector<TraceRing>(ompMaxThreads());
+    for (TraceRing& ring : state.rings) ring.events.resize(TRACE_RING_EVENTS);
+    state.origin = std::chrono::steady_clock::now();
+    state.enabled = true;
+}
+
+inline void disableTracing() {
+    traceState().enabled = false;
+}
+
+inline uint64_t traceNow() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - traceState().origin).count());
+}
+
+inline void recordTraceEvent(const TraceEvent& event) {
+    TraceState& state = traceState();
+    int thread = ompThreadNum();
+    if (thread >= static_cast<int>(state.rings.size())) return;
+    TraceRing& ring = state.rings[thread];
+    ring.events[ring.recorded % TRACE_RING_EVENTS] = event;
+    ring.recorded++;
+}
+
+// Records the span from construction to destruction when tracing is on
+class TraceScope {
+public:
+    TraceScope(TraceKind kind, int left, int right, int depth = 0, const char* name = nullptr) {
+        if (!traceEnabled()) return;
+        active_ = true;
+        event_ = {traceNow(), 0, left, right, depth, kind, name};
+    }
+
+    ~TraceScope() {
+        if (!active_) return;
+        event_.end = traceNow();
+        recordTraceEvent(event_);
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    bool active_ = false;
+    TraceEvent event_;
+};
+
+// Writes every ring as Chrome trace event JSON and reports overwritten events
+inline void writeChromeTrace(const std::string& path) {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Error opening file: " << path << std::endl;
+        exit(1);
+    }
+
+    const TraceState& state = traceState();
+    file.setf(std::ios::fixed);
+    file.precision(3);  // microseconds with nanosecond resolution
+    uint64_t dropped = 0;
+    bool first = true;
+    file << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+    for (size_t t = 0; t < state.rings.size(); t++) {
+        const TraceRing& ring = state.rings[t];
+        file << (first ? "\n" : ",\n") << "  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << t
+             << ", \"args\": {\"name\": \"OpenMP thread " << t << "\"}}";
+        first = false;
+
+        uint64_t kept = std::min<uint64_t>(ring.recorded, TRACE_RING_EVENTS);
+        dropped += ring.recorded - kept;
+        for (uint64_t i = ring.recorded - kept; i < ring.recorded; i++) {
+            const TraceEvent& event = ring.events[i % TRACE_RING_EVENTS];
+            file << ",\n  {\"name\": \"" << (event.name != nullptr ? event.name : traceKindName(event.kind))
+                 << "\", \"cat\": \"" << traceKindName(event.kind) << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << t
+                 << ", \"ts\": " << event.begin / 1000.0 << ", \"dur\": " << (event.end - event.begin) / 1000.0
+                 << ", \"args\": {\"left\": " << event.left << ", \"right\": " << event.right
+                 << ", \"size\": " << (static_cast<long long>(event.right) - event.left + 1)
+                 << ", \"depth\": " << event.depth << "}}";
+        }
+    }
+    file << "\n]}" << std::endl;
+
+    if (dropped > 0) {
+        std::cerr << "Warning: " << dropped << " trace events were overwritten (ring of "
+                  << TRACE_RING_EVENTS << " events per thread)" << std::endl;
+    }
+}
+
+#endif // TASK_TRACE_H
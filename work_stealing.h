@@ -0,0 +1,359 @@
+/*
+ * File: work_stealing.h
+ *
+ * Description:
+ * Work-stealing task scheduler that does not rely on the OpenMP runtime.
+ *
+ * Every worker owns a Chase-Lev deque (Chase and Lev, "Dynamic Circular
+ * Work-Stealing Deque", with the C11 memory orderings of Lê et al., PPoPP
+ * 2013). A worker pushes and pops its own tasks at the bottom, LIFO, and idle
+ * workers steal from the top of a random victim, FIFO, which hands them the
+ * largest remaining pieces of a divide-and-conquer recursion.
+ *
+ * Joins are continuation-style instead of blocking: a task counts its
+ * outstanding children, and whichever child finishes last runs the parent's
+ * onComplete() and then notifies the grandparent. No worker ever waits inside
+ * a task the way "#pragma omp taskwait" does, so it can go on to other work.
+ *
+ * The thread calling run() works as worker 0 until the root task and all its
+ * descendants are done. Between runs the other workers spin briefly, so that
+ * back-to-back runs find them awake, and then sleep on a condition variable,
+ * so an idle pool takes no CPU time from the OpenMP team. Workers can
+ * optionally be pinned to one CPU each, chosen among the CPUs the OpenMP team
+ * thread of the same index may run on: each CPU of the process affinity mask
+ * in turn when the team is unbound, or the thread's place under
+ * OMP_PROC_BIND / OMP_PLACES.
+ */
+
+#ifndef WORK_STEALING_H
+#define WORK_STEALING_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+#include "omp_compat.h"
+
+class WorkStealingPool;
+class WsWorker;
+
+// How often an idle worker re-checks for a new run before going to sleep
+const int WS_SPIN_BEFORE_SLEEP = 64;
+
+// Unit of work. Subclasses implement execute() and may spawn children from
+// it; onComplete() runs once the task and all of its children have finished.
+class WsTask {
+public:
+    virtual ~WsTask() = default;
+    virtual void execute(WsWorker& worker) = 0;
+    virtual void onComplete(WsWorker& /*worker*/) {}
+
+private:
+    friend class WsWorker;
+    friend class WorkStealingPool;
+
+    WsTask* parent_ = nullptr;
+    std::atomic<int> pending_{1};  // the task itself plus outstanding children
+};
+
+// Chase-Lev deque of task pointers with a growable circular buffer. Only the
+// owner calls push/take; any thread may call steal.
+class ChaseLevDeque {
+public:
+    explicit ChaseLevDeque(int logCapacity = 10) {
+        buffers_.emplace_back(new Buffer(logCapacity));
+        buffer_.store(buffers_.back().get(), std::memory_order_relaxed);
+    }
+
+    void push(WsTask* task) {
+        long long b = bottom_.load(std::memory_order_relaxed);
+        long long t = top_.load(std::memory_order_acquire);
+        Buffer* a = buffer_.load(std::memory_order_relaxed);
+        if (b - t > a->capacity() - 1) {
+            a = grow(a, t, b);
+        }
+        a->put(b, task);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+
+    WsTask* take() {
+        long long b = bottom_.load(std::memory_order_relaxed) - 1;
+        Buffer* a = buffer_.load(std::memory_order_relaxed);
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        long long t = top_.load(std::memory_order_relaxed);
+
+        WsTask* task = nullptr;
+        if (t <= b) {
+            task = a->get(b);
+            if (t == b) {
+                // Last element: race against thieves for it
+                if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                    task = nullptr;
+                }
+                bottom_.store(b + 1, std::memory_order_relaxed);
+            }
+        } else {
+            bottom_.store(b + 1, std::memory_order_relaxed);
+        }
+        return task;
+    }
+
+    WsTask* steal() {
+        long long t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        long long b = bottom_.load(std::memory_order_acquire);
+        if (t >= b) return nullptr;
+
+        Buffer* a = buffer_.load(std::memory_order_acquire);
+        WsTask* task = a->get(t);
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return task;
+    }
+
+private:
+    class Buffer {
+    public:
+        explicit Buffer(int logCapacity) : mask_((1LL << logCapacity) - 1), logCapacity_(logCapacity),
+                                           slots_(new std::atomic<WsTask*>[1LL << logCapacity]) {}
+
+        long long capacity() const { return mask_ + 1; }
+        int logCapacity() const { return logCapacity_; }
+        WsTask* get(long long i) const { return slots_[i & mask_].load(std::memory_order_relaxed); }
+        void put(long long i, WsTask* task) { slots_[i & mask_].store(task, std::memory_order_relaxed); }
+
+    private:
+        long long mask_;
+        int logCapacity_;
+        std::unique_ptr<std::atomic<WsTask*>[]> slots_;
+    };
+
+    // Old buffers stay alive until the deque is destroyed, since a thief may
+    // still be reading from one
+    Buffer* grow(Buffer* old, long long t, long long b) {
+        buffers_.emplace_back(new Buffer(old->logCapacity() + 1));
+        Buffer* bigger = buffers_.back().get();
+        for (long long i = t; i < b; i++) bigger->put(i, old->get(i));
+        buffer_.store(bigger, std::memory_order_release);
+        return bigger;
+    }
+
+    alignas(64) std::atomic<long long> top_{0};
+    alignas(64) std::atomic<long long> bottom_{0};
+    std::atomic<Buffer*> buffer_{nullptr};
+    std::vector<std::unique_ptr<Buffer>> buffers_;
+};
+
+// Per-thread view of the pool handed to running tasks
+class WsWorker {
+public:
+    WsWorker(WorkStealingPool& pool, int index) : pool_(pool), index_(index), rng_(0x9E3779B97F4A7C15ull * (index + 1)) {}
+
+    // Makes child a child of parent and queues it on this worker's deque
+    void spawn(WsTask* parent, WsTask* child) {
+        child->parent_ = parent;
+        parent->pending_.fetch_add(1, std::memory_order_relaxed);
+        deque_.push(child);
+    }
+
+    int index() const { return index_; }
+
+private:
+    friend class WorkStealingPool;
+
+    uint64_t nextRandom() {
+        rng_ ^= rng_ << 13;
+        rng_ ^= rng_ >> 7;
+        rng_ ^= rng_ << 17;
+        return rng_;
+    }
+
+    WorkStealingPool& pool_;
+    int index_;
+    uint64_t rng_;
+    ChaseLevDeque deque_;
+};
+
+class WorkStealingPool {
+public:
+    // With pinWorkers set, worker i (i >= 1) is bound to one CPU of the set
+    // OpenMP team thread i runs on (see above); worker 0 is whichever thread
+    // calls run()
+    explicit WorkStealingPool(int numWorkers, bool pinWorkers = false) {
+        if (numWorkers < 1) numWorkers = 1;
+        for (int i = 0; i < numWorkers; i++) workers_.emplace_back(new WsWorker(*this, i));
+        for (int i = 1; i < numWorkers; i++) threads_.emplace_back([this, i] { workerLoop(i); });
+
+        if (pinWorkers && numWorkers > 1) {
+            std::vector<std::vector<int>> teamCpus = teamCpuLists();
+            for (int i = 1; i < numWorkers; i++) {
+                const std::vector<int>& cpus = teamCpus[i % teamCpus.size()];
+                if (cpus.empty()) continue;
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                CPU_SET(cpus[i % cpus.size()], &set);
+                pthread_setaffinity_np(threads_[i - 1].native_handle(), sizeof(set), &set);
+            }
+        }
+    }
+
+    ~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            shutdown_ = true;
+        }
+        wake_.notify_all();
+        for (std::thread& thread : threads_) thread.join();
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    int size() const { return static_cast<int>(workers_.size()); }
+
+    // Runs root (taking ownership) and returns once it and every descendant
+    // have completed. The calling thread works as worker 0 meanwhile.
+    void run(WsTask* root) {
+        std::lock_guard<std::mutex> runLock(runMutex_);
+        done_.store(false, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            active_ = true;
+            generation_.fetch_add(1, std::memory_order_release);
+        }
+        wake_.notify_all();
+
+        WsWorker& self = *workers_[0];
+        root->parent_ = nullptr;
+        self.deque_.push(root);
+        workUntilDone(self);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        active_ = false;
+    }
+
+private:
+    // CPUs each thread of an OpenMP team may run on, from sched_getaffinity
+    // inside the team, so the lists follow the process mask and OMP_PLACES
+    static std::vector<std::vector<int>> teamCpuLists() {
+        std::vector<std::vector<int>> lists(ompMaxThreads());
+        #pragma omp parallel
+        {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+                std::vector<int>& cpus = lists[ompThreadNum()];
+                for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+                    if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+                }
+            }
+        }
+        return lists;
+    }
+
+    // Called when task's own execute() or one of its children has finished
+    void release(WsWorker& worker, WsTask* task) {
+        while (task != nullptr && task->pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            task->onComplete(worker);
+            WsTask* parent = task->parent_;
+            delete task;
+            if (parent == nullptr) {
+                done_.store(true, std::memory_order_release);
+            }
+            task = parent;
+        }
+    }
+
+    WsTask* findTask(WsWorker& worker) {
+        if (WsTask* task = worker.deque_.take()) return task;
+        int n = size();
+        if (n == 1) return nullptr;
+        for (int attempt = 0; attempt < 2 * n; attempt++) {
+            int victim = static_cast<int>(worker.nextRandom() % n);
+            if (victim == worker.index_) continue;
+            if (WsTask* task = workers_[victim]->deque_.steal()) return task;
+        }
+        return nullptr;
+    }
+
+    void workUntilDone(WsWorker& worker) {
+        int idleRounds = 0;
+        while (!done_.load(std::memory_order_acquire)) {
+            WsTask* task = findTask(worker);
+            if (task == nullptr) {
+                if (++idleRounds > 64) std::this_thread::yield();
+                continue;
+            }
+            idleRounds = 0;
+            task->execute(worker);
+            release(worker, task);
+        }
+    }
+
+    void workerLoop(int index) {
+        WsWorker& self = *workers_[index];
+        unsigned long long seen = 0;
+        while (true) {
+            // Stay warm for a while after a run before blocking
+            for (int spin = 0; spin < WS_SPIN_BEFORE_SLEEP; spin++) {
+                if (generation_.load(std::memory_order_acquire) != seen) break;
+                std::this_thread::yield();
+            }
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait(lock, [&] { return shutdown_ || (active_ && generation_.load(std::memory_order_relaxed) != seen); });
+                if (shutdown_) return;
+                seen = generation_.load(std::memory_order_relaxed);
+            }
+            workUntilDone(self);
+        }
+    }
+
+    std::vector<std::unique_ptr<WsWorker>> workers_;
+    std::vector<std::thread> threads_;
+    std::mutex runMutex_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool active_ = false;
+    bool shutdown_ = false;
+    std::atomic<unsigned long long> generation_{0};
+    std::atomic<bool> done_{false};
+};
+
+// Splits [begin, end) in halves down to single indices and calls f on each
+template <typename F>
+class WsRangeTask : public WsTask {
+public:
+    WsRangeTask(int begin, int end, F* f) : begin_(begin), end_(end), f_(f) {}
+
+    void execute(WsWorker& worker) override {
+        while (end_ - begin_ > 1) {
+            int mid = begin_ + (end_ - begin_) / 2;
+            worker.spawn(this, new WsRangeTask(mid, end_, f_));
+            end_ = mid;
+        }
+        (*f_)(begin_);
+    }
+
+private:
+    int begin_;
+    int end_;
+    F* f_;
+};
+
+// Calls f(i) for every i in [0, count) on the pool and returns when all are done
+template <typename F>
+void parallelFor(WorkStealingPool& pool, int count, F f) {
+    if (count <= 0) return;
+    pool.run(new WsRangeTask<F>(0, count, &f));
+}
+
+#endif // WORK_STEALING_H